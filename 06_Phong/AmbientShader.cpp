@@ -3,3 +3,11 @@
 Vec3 AmbientShader::shade(Vertex surface) const {
 	return surface.material.color_ambient;
 }
+
+void AmbientShader::shadeBatch(ShadingBatch& batch) const {
+  for (size_t i = 0; i < batch.size; ++i) {
+    batch.red[i] = batch.ambientR[i];
+    batch.green[i] = batch.ambientG[i];
+    batch.blue[i] = batch.ambientB[i];
+  }
+}
@@ -4,5 +4,6 @@
 class AmbientShader : public Shader {
 public:
   Vec3 shade(Vertex surface) const override;
+  void shadeBatch(ShadingBatch& batch) const override;
   virtual ~AmbientShader() {}
 };
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <limits>
+
+#include "DepthBuffer.h"
+
+constexpr float empty = -std::numeric_limits<float>::infinity();
+
+DepthBuffer::DepthBuffer(uint32_t width, uint32_t height)
+: width(width), height(height), data(size_t(width) * height, empty),
+  blocksX((width + blockSize - 1) / blockSize),
+  blockMin(size_t(blocksX) * ((height + blockSize - 1) / blockSize), empty),
+  blockMax(blockMin.size(), empty)
+{
+}
+
+DepthBuffer::DepthBuffer(const Image& image)
+: DepthBuffer(image.width, image.height)
+{
+}
+
+void DepthBuffer::clear() {
+  std::fill(data.begin(), data.end(), empty);
+  std::fill(blockMin.begin(), blockMin.end(), empty);
+  std::fill(blockMax.begin(), blockMax.end(), empty);
+}
+
+float DepthBuffer::getValue(uint32_t x, uint32_t y) const {
+  return data[size_t(y) * width + x];
+}
+
+float DepthBuffer::getBlockMin(uint32_t blockX, uint32_t blockY) const {
+  return blockMin[size_t(blockY) * blocksX + blockX];
+}
+
+float DepthBuffer::getBlockMax(uint32_t blockX, uint32_t blockY) const {
+  return blockMax[size_t(blockY) * blocksX + blockX];
+}
+
+void DepthBuffer::updateBlock(uint32_t blockX, uint32_t blockY) {
+  const uint32_t x0 = blockX * blockSize;
+  const uint32_t y0 = blockY * blockSize;
+  const uint32_t x1 = std::min(x0 + blockSize, width);
+  const uint32_t y1 = std::min(y0 + blockSize, height);
+
+  float minValue = std::numeric_limits<float>::infinity();
+  float maxValue = empty;
+  for (uint32_t y = y0; y < y1; ++y) {
+    const float* row = data.data() + size_t(y) * width;
+    for (uint32_t x = x0; x < x1; ++x) {
+      minValue = std::min(minValue, row[x]);
+      maxValue = std::max(maxValue, row[x]);
+    }
+  }
+  blockMin[size_t(blockY) * blocksX + blockX] = minValue;
+  blockMax[size_t(blockY) * blocksX + blockX] = maxValue;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Image.h"
+
+/**
+ * Depth values of the pixels of an image together with a coarse hierarchy:
+ * the smallest and largest value of every block of blockSize x blockSize
+ * pixels. The blocks lie on the same grid as the blocks Triangle::draw
+ * works on, so a triangle can be rejected for a whole block by comparing
+ * its depth range with the range stored for the block.
+ *
+ * Like the positions of the vertices, larger values are closer to the
+ * viewer. An empty buffer holds -infinity everywhere.
+ */
+class DepthBuffer {
+public:
+  static constexpr uint32_t blockSize = 8;
+
+  uint32_t width;
+  uint32_t height;
+  std::vector<float> data;  // row by row like Image::data
+
+  DepthBuffer(uint32_t width = 100, uint32_t height = 100);
+
+  /**
+   * Creates an empty buffer of the same size as the image.
+   */
+  explicit DepthBuffer(const Image& image);
+
+  void clear();
+
+  float getValue(uint32_t x, uint32_t y) const;
+  float getBlockMin(uint32_t blockX, uint32_t blockY) const;
+  float getBlockMax(uint32_t blockX, uint32_t blockY) const;
+
+  /**
+   * Recomputes the range of a block, has to be called after values of the
+   * block were changed in data.
+   */
+  void updateBlock(uint32_t blockX, uint32_t blockY);
+
+private:
+  uint32_t blocksX;
+  std::vector<float> blockMin;
+  std::vector<float> blockMax;
+};
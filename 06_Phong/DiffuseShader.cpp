@@ -14,4 +14,26 @@ Vec3 DiffuseShader::shade(Vertex surface) const {
   return m.color_diffuse * ld * d;
 }
 
+void DiffuseShader::shadeBatch(ShadingBatch& batch) const {
+  for (size_t i = 0; i < batch.size; ++i) {
+    const float nx = batch.normalX[i];
+    const float ny = batch.normalY[i];
+    const float nz = batch.normalZ[i];
+    const float nLength = std::sqrt(nx * nx + ny * ny + nz * nz);
 
+    const float lx = light.x - batch.positionX[i];
+    const float ly = light.y - batch.positionY[i];
+    const float lz = light.z - batch.positionZ[i];
+    const float lLength = std::sqrt(lx * lx + ly * ly + lz * lz);
+
+    // normalizing a zero vector gives NaN here instead of a zero vector, the
+    // comparison below maps both to no light just like shade does
+    const float dot = (nx / nLength) * (lx / lLength) + (ny / nLength) * (ly / lLength) +
+                      (nz / nLength) * (lz / lLength);
+    const float d = dot > 0.0f ? dot : 0.0f;
+
+    batch.red[i] = batch.diffuseR[i] * ld.r * d;
+    batch.green[i] = batch.diffuseG[i] * ld.g * d;
+    batch.blue[i] = batch.diffuseB[i] * ld.b * d;
+  }
+}
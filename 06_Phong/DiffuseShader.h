@@ -12,6 +12,7 @@ public:
 
   // Inherited via Shader
   virtual Vec3 shade(Vertex surface) const override;
+  virtual void shadeBatch(ShadingBatch& batch) const override;
 };
 
 
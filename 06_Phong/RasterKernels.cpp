@@ -0,0 +1,278 @@
+#include <algorithm>
+
+#include "RasterKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+  #define RASTER_X86 1
+  #include <immintrin.h>
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define TARGET_AVX2
+  #else
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#else
+  #define RASTER_X86 0
+#endif
+
+namespace {
+
+constexpr uint32_t laneCount = 8;
+
+void append(BlockPixels& pixels, uint32_t x, uint32_t y, float a0, float a1, float a2) {
+  const size_t i = pixels.size++;
+  pixels.x[i] = x;
+  pixels.y[i] = y;
+  pixels.a0[i] = a0;
+  pixels.a1[i] = a1;
+  pixels.a2[i] = a2;
+}
+
+// ---- scalar fallback, one pixel at a time ----
+
+void coverBlockScalar(const BlockSetup& s, BlockPixels& pixels) {
+  float rowA0 = s.a0;
+  float rowA1 = s.a1;
+  float* depthRow = s.depth;
+  for (uint32_t row = 0; row < s.rows; ++row) {
+    for (uint32_t lane = 0; lane < laneCount; ++lane) {
+      if (!(s.laneMask & (1u << lane))) continue;
+
+      const float a0 = rowA0 + float(lane) * s.a0dx;
+      const float a1 = rowA1 + float(lane) * s.a1dx;
+      const float a2 = 1.0f - a0 - a1;
+      if (!s.inside && !(a0 >= -s.epsilon && a1 >= -s.epsilon && a2 >= -s.epsilon)) continue;
+
+      // early depth test, hidden pixels are not shaded
+      if (depthRow) {
+        const float z = a0 * s.z0 + a1 * s.z1 + a2 * s.z2;
+        if (!s.depthVisible && !(z >= depthRow[lane])) continue;
+        depthRow[lane] = z;
+      }
+      append(pixels, s.blockX + lane, s.fromY + row, a0, a1, a2);
+    }
+    rowA0 += s.a0dy;
+    rowA1 += s.a1dy;
+    if (depthRow) depthRow += s.depthStride;
+  }
+}
+
+#if RASTER_X86
+
+// appends the lanes set in mask, the arrays hold the values of all 8 lanes
+void appendLanes(const BlockSetup& s, BlockPixels& pixels, uint32_t mask, uint32_t row,
+                 float* depthRow, const float* z, const float* a0, const float* a1, const float* a2) {
+  for (uint32_t lane = 0; lane < laneCount; ++lane) {
+    if (!(mask & (1u << lane))) continue;
+    if (depthRow) depthRow[lane] = z[lane];
+    append(pixels, s.blockX + lane, s.fromY + row, a0[lane], a1[lane], a2[lane]);
+  }
+}
+
+// the depth of all 8 lanes, lanes outside of the buffer are not read
+void loadDepth(const BlockSetup& s, const float* depthRow, float* stored) {
+  for (uint32_t lane = 0; lane < laneCount; ++lane)
+    stored[lane] = (s.depthLanes & (1u << lane)) ? depthRow[lane] : 0.0f;
+}
+
+// ---- SSE, two halves of 4 lanes ----
+
+void coverBlockSSE(const BlockSetup& s, BlockPixels& pixels) {
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 minusEpsilon = _mm_set1_ps(-s.epsilon);
+  const __m128 z0 = _mm_set1_ps(s.z0);
+  const __m128 z1 = _mm_set1_ps(s.z1);
+  const __m128 z2 = _mm_set1_ps(s.z2);
+  const __m128 lanesLo = _mm_set_ps(3, 2, 1, 0);
+  const __m128 lanesHi = _mm_set_ps(7, 6, 5, 4);
+  const __m128 offsetA0[2] = { _mm_mul_ps(lanesLo, _mm_set1_ps(s.a0dx)), _mm_mul_ps(lanesHi, _mm_set1_ps(s.a0dx)) };
+  const __m128 offsetA1[2] = { _mm_mul_ps(lanesLo, _mm_set1_ps(s.a1dx)), _mm_mul_ps(lanesHi, _mm_set1_ps(s.a1dx)) };
+
+  alignas(16) float a0[laneCount], a1[laneCount], a2[laneCount], z[laneCount], stored[laneCount];
+  float rowA0 = s.a0;
+  float rowA1 = s.a1;
+  float* depthRow = s.depth;
+  for (uint32_t row = 0; row < s.rows; ++row) {
+    if (depthRow && !s.depthVisible) {
+      if (s.depthLanes == 0xFF)
+        std::copy(depthRow, depthRow + laneCount, stored);
+      else
+        loadDepth(s, depthRow, stored);
+    }
+
+    uint32_t mask = 0;
+    for (uint32_t half = 0; half < 2; ++half) {
+      const __m128 va0 = _mm_add_ps(_mm_set1_ps(rowA0), offsetA0[half]);
+      const __m128 va1 = _mm_add_ps(_mm_set1_ps(rowA1), offsetA1[half]);
+      const __m128 va2 = _mm_sub_ps(_mm_sub_ps(one, va0), va1);
+      __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+      if (!s.inside)
+        visible = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(va0, minusEpsilon), _mm_cmpge_ps(va1, minusEpsilon)),
+                             _mm_cmpge_ps(va2, minusEpsilon));
+      if (depthRow) {
+        const __m128 vz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(va0, z0), _mm_mul_ps(va1, z1)), _mm_mul_ps(va2, z2));
+        if (!s.depthVisible)
+          visible = _mm_and_ps(visible, _mm_cmpge_ps(vz, _mm_load_ps(stored + 4 * half)));
+        _mm_store_ps(z + 4 * half, vz);
+      }
+      _mm_store_ps(a0 + 4 * half, va0);
+      _mm_store_ps(a1 + 4 * half, va1);
+      _mm_store_ps(a2 + 4 * half, va2);
+      mask |= uint32_t(_mm_movemask_ps(visible)) << (4 * half);
+    }
+    mask &= s.laneMask;
+    if (mask)
+      appendLanes(s, pixels, mask, row, depthRow, z, a0, a1, a2);
+
+    rowA0 += s.a0dy;
+    rowA1 += s.a1dy;
+    if (depthRow) depthRow += s.depthStride;
+  }
+}
+
+// ---- AVX2, all 8 lanes at once ----
+
+// for every mask the lanes set in it, packed to the front, and their count
+struct CompressTable {
+  alignas(8) uint8_t lanes[256][laneCount];
+  uint8_t count[256];
+
+  constexpr CompressTable() : lanes{}, count{} {
+    for (uint32_t mask = 0; mask < 256; ++mask) {
+      uint8_t n = 0;
+      for (uint32_t lane = 0; lane < laneCount; ++lane)
+        if (mask & (1u << lane)) lanes[mask][n++] = uint8_t(lane);
+      count[mask] = n;
+    }
+  }
+};
+
+constexpr CompressTable compressTable;
+
+TARGET_AVX2 __m256i laneMaskVector(uint32_t mask) {
+  const __m256i bits = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+  return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(int32_t(mask)), bits), bits);
+}
+
+TARGET_AVX2 void coverBlockAVX2(const BlockSetup& s, BlockPixels& pixels) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 minusEpsilon = _mm256_set1_ps(-s.epsilon);
+  const __m256 z0 = _mm256_set1_ps(s.z0);
+  const __m256 z1 = _mm256_set1_ps(s.z1);
+  const __m256 z2 = _mm256_set1_ps(s.z2);
+  const __m256 lanes = _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0);
+  const __m256 offsetA0 = _mm256_mul_ps(lanes, _mm256_set1_ps(s.a0dx));
+  const __m256 offsetA1 = _mm256_mul_ps(lanes, _mm256_set1_ps(s.a1dx));
+  const __m256i x = _mm256_add_epi32(_mm256_set1_epi32(int32_t(s.blockX)), _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+  const __m256i depthLanes = laneMaskVector(s.depthLanes);
+
+  float rowA0 = s.a0;
+  float rowA1 = s.a1;
+  float* depthRow = s.depth;
+  for (uint32_t row = 0; row < s.rows; ++row) {
+    const __m256 a0 = _mm256_add_ps(_mm256_set1_ps(rowA0), offsetA0);
+    const __m256 a1 = _mm256_add_ps(_mm256_set1_ps(rowA1), offsetA1);
+    const __m256 a2 = _mm256_sub_ps(_mm256_sub_ps(one, a0), a1);
+
+    uint32_t mask = s.laneMask;
+    if (!s.inside) {
+      const __m256 covered = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(a0, minusEpsilon, _CMP_GE_OQ),
+                                                         _mm256_cmp_ps(a1, minusEpsilon, _CMP_GE_OQ)),
+                                           _mm256_cmp_ps(a2, minusEpsilon, _CMP_GE_OQ));
+      mask &= uint32_t(_mm256_movemask_ps(covered));
+    }
+
+    if (mask && depthRow) {
+      const __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a0, z0), _mm256_mul_ps(a1, z1)),
+                                     _mm256_mul_ps(a2, z2));
+      if (!s.depthVisible) {
+        // lanes outside of the buffer are not read
+        const __m256 stored = _mm256_maskload_ps(depthRow, depthLanes);
+        mask &= uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(z, stored, _CMP_GE_OQ)));
+      }
+      _mm256_maskstore_ps(depthRow, laneMaskVector(mask), z);
+    }
+
+    if (mask) {
+      // packs the visible lanes to the front and appends all eight, at most
+      // eight pixels per row were appended so far, so this stays in bounds
+      const __m256i order = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(compressTable.lanes[mask])));
+      const size_t i = pixels.size;
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels.x + i), _mm256_permutevar8x32_epi32(x, order));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels.y + i), _mm256_set1_epi32(int32_t(s.fromY + row)));
+      _mm256_storeu_ps(pixels.a0 + i, _mm256_permutevar8x32_ps(a0, order));
+      _mm256_storeu_ps(pixels.a1 + i, _mm256_permutevar8x32_ps(a1, order));
+      _mm256_storeu_ps(pixels.a2 + i, _mm256_permutevar8x32_ps(a2, order));
+      pixels.size += compressTable.count[mask];
+    }
+
+    rowA0 += s.a0dy;
+    rowA1 += s.a1dy;
+    if (depthRow) depthRow += s.depthStride;
+  }
+}
+
+#endif
+
+const RasterKernels scalarKernels{ coverBlockScalar };
+#if RASTER_X86
+const RasterKernels sseKernels{ coverBlockSSE };
+const RasterKernels avx2Kernels{ coverBlockAVX2 };
+#endif
+
+}
+
+SIMDLevel detectSIMDLevel() {
+#if RASTER_X86
+  #if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] >= 7) {
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    // the OS also has to save the upper halves of the ymm registers
+    if (osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6)
+      return SIMDLevel::AVX2;
+  }
+  return SIMDLevel::SSE;
+  #else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return SIMDLevel::AVX2;
+  return SIMDLevel::SSE;
+  #endif
+#else
+  return SIMDLevel::SCALAR;
+#endif
+}
+
+std::string toString(SIMDLevel level) {
+  switch (level) {
+    case SIMDLevel::AVX2: return "AVX2";
+    case SIMDLevel::SSE: return "SSE";
+    default: return "scalar";
+  }
+}
+
+const RasterKernels& getRasterKernels(SIMDLevel level) {
+  static const SIMDLevel supported = detectSIMDLevel();
+  if (int(level) > int(supported))
+    level = supported;
+#if RASTER_X86
+  switch (level) {
+    case SIMDLevel::AVX2: return avx2Kernels;
+    case SIMDLevel::SSE: return sseKernels;
+    default: break;
+  }
+#endif
+  return scalarKernels;
+}
+
+const RasterKernels& getRasterKernels() {
+  static const RasterKernels& kernels = getRasterKernels(detectSIMDLevel());
+  return kernels;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class SIMDLevel {
+  SCALAR, SSE, AVX2
+};
+
+/**
+ * Pixels of one block a triangle covers and that passed the depth test,
+ * together with their barycentric coordinates.
+ */
+struct BlockPixels {
+  static constexpr size_t maxSize = 64;
+
+  size_t size = 0;
+  uint32_t x[maxSize];
+  uint32_t y[maxSize];
+  float a0[maxSize];
+  float a1[maxSize];
+  float a2[maxSize];
+};
+
+/**
+ * Everything a kernel needs to know about the part of a block of at most
+ * 8x8 pixels a triangle may cover. Lane i of a row is the pixel
+ * blockX + i, rows start at fromY.
+ */
+struct BlockSetup {
+  uint32_t blockX;
+  uint32_t fromY;
+  uint32_t rows;
+  uint32_t laneMask;    // lanes inside the bounding box and the drawn rectangle
+
+  float a0, a1;         // barycentric coordinates at (blockX, fromY)
+  float a0dx, a0dy;
+  float a1dx, a1dy;
+  float epsilon;
+  bool inside;          // the whole block lies inside of all edges
+
+  float z0, z1, z2;     // depth of the vertices
+  float* depth;         // depth at (blockX, fromY) or nullptr without depth test
+  size_t depthStride;   // distance between two rows of depth
+  uint32_t depthLanes;  // lanes that lie inside the depth buffer
+  bool depthVisible;    // the triangle is in front of the whole block
+};
+
+/**
+ * Coverage kernels of the rasterizer. They evaluate the edge functions of
+ * eight pixels of a row at once, test the depth of the covered pixels
+ * against the depth buffer, store the depth of the visible ones and append
+ * them to pixels. All kernels do the same arithmetic in the same order, so
+ * they produce exactly the same pixels.
+ */
+struct RasterKernels {
+  void (*coverBlock)(const BlockSetup& setup, BlockPixels& pixels);
+};
+
+/**
+ * Highest instruction set supported by the CPU we are running on.
+ */
+SIMDLevel detectSIMDLevel();
+std::string toString(SIMDLevel level);
+
+/**
+ * Kernels for the given level, levels that are not compiled in or not
+ * supported by the CPU fall back to the next lower one.
+ */
+const RasterKernels& getRasterKernels(SIMDLevel level);
+const RasterKernels& getRasterKernels();
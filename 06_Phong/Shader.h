@@ -2,9 +2,21 @@
 
 #include "Vec3.h"
 #include "Vertex.h"
+#include "ShadingBatch.h"
 
 class Shader {
 public:
   virtual Vec3 shade(Vertex surface) const = 0;
+
+  /**
+   * Shades the pixels of a batch. The rasterizer calls this once per block
+   * of pixels instead of shade per pixel. This default calls shade for every
+   * pixel, shaders override it with loops over the attribute arrays.
+   */
+  virtual void shadeBatch(ShadingBatch& batch) const {
+    for (size_t i = 0; i < batch.size; ++i)
+      batch.setColor(i, shade(batch.getVertex(i)));
+  }
+
   virtual ~Shader() {}
 };
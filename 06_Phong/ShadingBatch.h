@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+#include "Vertex.h"
+
+/**
+ * Interpolated surface attributes of up to maxSize pixels, one array per
+ * component, so that shaders can process a whole batch with simple loops
+ * the compiler can vectorize. The rasterizer fills the attribute arrays of
+ * the first size entries, the shader stores its colors in red, green and
+ * blue.
+ */
+struct ShadingBatch {
+  static constexpr size_t maxSize = 64;
+
+  size_t size = 0;
+
+  float positionX[maxSize], positionY[maxSize], positionZ[maxSize];
+  float normalX[maxSize], normalY[maxSize], normalZ[maxSize];
+  float ambientR[maxSize], ambientG[maxSize], ambientB[maxSize];
+  float diffuseR[maxSize], diffuseG[maxSize], diffuseB[maxSize];
+  float specularR[maxSize], specularG[maxSize], specularB[maxSize];
+
+  float red[maxSize], green[maxSize], blue[maxSize];
+
+  Vertex getVertex(size_t i) const {
+    return Vertex{ Vec3{ positionX[i], positionY[i], positionZ[i] },
+                   Material{ Vec3{ ambientR[i], ambientG[i], ambientB[i] },
+                             Vec3{ diffuseR[i], diffuseG[i], diffuseB[i] },
+                             Vec3{ specularR[i], specularG[i], specularB[i] } },
+                   Vec3{ normalX[i], normalY[i], normalZ[i] } };
+  }
+
+  void setColor(size_t i, const Vec3& color) {
+    red[i] = color.r;
+    green[i] = color.g;
+    blue[i] = color.b;
+  }
+};
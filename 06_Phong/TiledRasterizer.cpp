@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "TiledRasterizer.h"
+
+TiledRasterizer::TiledRasterizer(uint32_t tileSize, uint32_t threadCount)
+: threadCount(threadCount)
+{
+  setTileSize(tileSize);
+}
+
+void TiledRasterizer::draw(const std::vector<Triangle>& triangles, Image& image,
+                           DepthBuffer* depth) {
+  if (triangles.empty() || image.width == 0 || image.height == 0) return;
+
+  const uint32_t tilesX = (image.width + tileSize - 1) / tileSize;
+  const uint32_t tilesY = (image.height + tileSize - 1) / tileSize;
+  const uint32_t tileCount = tilesX * tilesY;
+  const uint32_t workerCount = getThreadCount();
+
+  // front end: every thread bins a contiguous part of the list, reading the
+  // parts in order later on restores the order of the whole list
+  const uint32_t partCount = uint32_t(std::min<size_t>(workerCount, triangles.size()));
+  bins.resize(partCount);
+  for (std::vector<std::vector<uint32_t>>& part : bins) {
+    part.resize(tileCount);
+    for (std::vector<uint32_t>& bin : part)
+      bin.clear();
+  }
+
+  forEachThread(partCount, [&](uint32_t part) {
+    const size_t begin = triangles.size() * part / partCount;
+    const size_t end = triangles.size() * (part + 1) / partCount;
+    for (size_t i = begin; i < end; ++i) {
+      uint32_t x0, y0, x1, y1;
+      if (!triangles[i].getBounds(image, x0, y0, x1, y1)) continue;
+      for (uint32_t tileY = y0 / tileSize; tileY <= (y1 - 1) / tileSize; ++tileY)
+        for (uint32_t tileX = x0 / tileSize; tileX <= (x1 - 1) / tileSize; ++tileX)
+          bins[part][tileY * tilesX + tileX].push_back(uint32_t(i));
+    }
+  });
+
+  // back end: the threads take the next tile until all are drawn
+  std::atomic<uint32_t> nextTile{0};
+  forEachThread(std::min(workerCount, tileCount), [&](uint32_t) {
+    for (uint32_t tile = nextTile++; tile < tileCount; tile = nextTile++) {
+      const uint32_t x0 = (tile % tilesX) * tileSize;
+      const uint32_t y0 = (tile / tilesX) * tileSize;
+      const uint32_t x1 = std::min(x0 + tileSize, image.width);
+      const uint32_t y1 = std::min(y0 + tileSize, image.height);
+      for (const std::vector<std::vector<uint32_t>>& part : bins)
+        for (const uint32_t i : part[tile])
+          triangles[i].draw(image, depth, x0, y0, x1, y1);
+    }
+  });
+}
+
+void TiledRasterizer::setTileSize(uint32_t tileSize) {
+  // tiles made of whole blocks keep the result independent of the tiling
+  const uint32_t blockSize = Triangle::blockSize;
+  this->tileSize = std::max(1u, (tileSize + blockSize - 1) / blockSize) * blockSize;
+}
+
+uint32_t TiledRasterizer::getTileSize() const {
+  return tileSize;
+}
+
+void TiledRasterizer::setThreadCount(uint32_t threadCount) {
+  this->threadCount = threadCount;
+}
+
+uint32_t TiledRasterizer::getThreadCount() const {
+#ifdef __EMSCRIPTEN__
+  // the web build is compiled without pthread support
+  return 1;
+#else
+  if (threadCount > 0)
+    return threadCount;
+  return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+void TiledRasterizer::forEachThread(uint32_t count, const std::function<void(uint32_t)>& work) {
+  std::vector<std::thread> threads;
+  for (uint32_t id = 1; id < count; ++id)
+    threads.emplace_back(work, id);
+  if (count > 0)
+    work(0);
+  for (std::thread& thread : threads)
+    thread.join();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Image.h"
+#include "DepthBuffer.h"
+#include "Triangle.h"
+
+/**
+ * Draws lists of triangles with several threads.
+ *
+ * A front end sorts ("bins") the triangles into the screen tiles their
+ * bounding boxes overlap, every thread bins a contiguous part of the list.
+ * Then the threads rasterize and shade whole tiles, so no pixel is written
+ * by two threads and the image needs no locks. Inside a tile the triangles
+ * are drawn in the order of the list, so the result is the same as drawing
+ * them one after another with Triangle::draw. The tiles are made of whole
+ * blocks of the depth buffer, so its hierarchy needs no locks either. The
+ * shaders are called from several threads at once.
+ */
+class TiledRasterizer {
+public:
+  /**
+   * @param tileSize edge length of the square screen tiles in pixels, rounded
+   *                 up to a multiple of Triangle::blockSize
+   * @param threadCount number of threads, 0 uses one per hardware thread
+   */
+  TiledRasterizer(uint32_t tileSize = 64, uint32_t threadCount = 0);
+
+  void draw(const std::vector<Triangle>& triangles, Image& image,
+            DepthBuffer* depth = nullptr);
+
+  void setTileSize(uint32_t tileSize);
+  uint32_t getTileSize() const;
+  void setThreadCount(uint32_t threadCount);
+  uint32_t getThreadCount() const;
+
+private:
+  uint32_t tileSize;
+  uint32_t threadCount;
+
+  // bins[part][tile] lists the triangles of one part of the list that
+  // overlap the tile, kept between calls to reuse the memory
+  std::vector<std::vector<std::vector<uint32_t>>> bins;
+
+  static void forEachThread(uint32_t count, const std::function<void(uint32_t)>& work);
+};
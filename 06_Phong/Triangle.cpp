@@ -1,49 +1,227 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "Triangle.h"
+#include "RasterKernels.h"
 
 constexpr float epsilon = 0.000001f;
 
+static_assert(Triangle::blockSize == 8, "the kernels process rows of eight pixels");
+static_assert(Triangle::blockSize * Triangle::blockSize <= BlockPixels::maxSize &&
+              Triangle::blockSize * Triangle::blockSize <= ShadingBatch::maxSize,
+              "a block has to fit into one shading batch");
+
 Triangle::Triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
                    const Shader& s) : v0(v0), v1(v1), v2(v2), shader(s) {
 }
 
-void Triangle::draw(Image& image) {
-	const float det = (v1.position.y - v2.position.y) * (v0.position.x - v2.position.x) +
-                    (v2.position.x - v1.position.x) * (v0.position.y - v2.position.y);
-
-	for (uint32_t y = 0; y < image.height; ++y) {
-		for (uint32_t x = 0; x < image.width; ++x) {
-			const float a0 = ((v1.position.y - v2.position.y) * (x - v2.position.x) +
-                        (v2.position.x - v1.position.x) * (y - v2.position.y)) / det;
-			const float a1 = ((v2.position.y - v0.position.y) * (x - v2.position.x) +
-                        (v0.position.x - v2.position.x) * (y - v2.position.y)) / det;
-			const float a2 = 1 - a0 - a1;
-
-      if (0-epsilon <= a0 && 0-epsilon <= a1 && 0-epsilon <= a2 &&
-          1+epsilon >= a0 && 1+epsilon >= a1 && 1+epsilon >= a2) {
-        Vertex v;
-        v.position = interpolate(v0.position, a0, v1.position, a1, v2.position, a2);
-        v.normal = interpolate(v0.normal, a0, v1.normal, a1, v2.normal, a2);
-        v.material.color_ambient = interpolate(v0.material.color_ambient, a0,
-                    v1.material.color_ambient, a1, v2.material.color_ambient, a2);
-        v.material.color_diffuse = interpolate(v0.material.color_diffuse, a0,
-                    v1.material.color_diffuse, a1, v2.material.color_diffuse, a2);
-        v.material.color_specular = interpolate(v0.material.color_specular, a0,
-                    v1.material.color_specular, a1, v2.material.color_specular, a2);
-
-        const Vec3 color = Vec3{ shader.shade(v)};
-
-        image.setNormalizedValue(x, y, 0, color.r);
-        image.setNormalizedValue(x, y, 1, color.g);
-        image.setNormalizedValue(x, y, 2, color.b);
-        image.setNormalizedValue(x, y, 3, 1);
-      }			
-		}
-	}
+void Triangle::draw(Image& image, DepthBuffer* depth) const {
+  draw(image, depth, 0, 0, image.width, image.height);
 }
 
-Vec3 Triangle::interpolate(const Vec3& val0, float a0,
-                           const Vec3& val1, float a1, const Vec3& val2,
-                           float a2) {
-	return val0 * a0 + val1 * a1 + val2 * a2;
+bool Triangle::getBounds(const Image& image, uint32_t& x0, uint32_t& y0,
+                         uint32_t& x1, uint32_t& y1) const {
+  const Vec3& p0 = v0.position;
+  const Vec3& p1 = v1.position;
+  const Vec3& p2 = v2.position;
+
+	const float det = (p1.y - p2.y) * (p0.x - p2.x) +
+                    (p2.x - p1.x) * (p0.y - p2.y);
+
+  // degenerate triangles cover no pixel
+  if (det == 0 || image.width == 0 || image.height == 0) return false;
+
+  // only pixels inside the bounding box of the triangle can be covered
+  const float minX = std::floor(std::min({p0.x, p1.x, p2.x}));
+  const float minY = std::floor(std::min({p0.y, p1.y, p2.y}));
+  const float maxX = std::ceil(std::max({p0.x, p1.x, p2.x}));
+  const float maxY = std::ceil(std::max({p0.y, p1.y, p2.y}));
+  if (maxX < 0 || maxY < 0 || minX > image.width - 1 || minY > image.height - 1) return false;
+
+  x0 = uint32_t(std::max(minX, 0.0f));
+  y0 = uint32_t(std::max(minY, 0.0f));
+  x1 = uint32_t(std::min(maxX, float(image.width - 1))) + 1;
+  y1 = uint32_t(std::min(maxY, float(image.height - 1))) + 1;
+  return true;
 }
 
+void Triangle::draw(Image& image, DepthBuffer* depth, uint32_t x0, uint32_t y0,
+                    uint32_t x1, uint32_t y1) const {
+  uint32_t boundsX0, boundsY0, boundsX1, boundsY1;
+  if (!getBounds(image, boundsX0, boundsY0, boundsX1, boundsY1)) return;
+
+  const uint32_t startX = std::max(x0, boundsX0);
+  const uint32_t startY = std::max(y0, boundsY0);
+  uint32_t endX = std::min(x1, boundsX1);
+  uint32_t endY = std::min(y1, boundsY1);
+  if (depth) {
+    endX = std::min(endX, depth->width);
+    endY = std::min(endY, depth->height);
+  }
+  if (startX >= endX || startY >= endY) return;
+
+  const Vec3& p0 = v0.position;
+  const Vec3& p1 = v1.position;
+  const Vec3& p2 = v2.position;
+
+	const float det = (p1.y - p2.y) * (p0.x - p2.x) +
+                    (p2.x - p1.x) * (p0.y - p2.y);
+
+  // The barycentric coordinates a0 and a1 are linear functions of the pixel
+  // position (the edge functions of the edges opposite to v0 and v1 divided
+  // by det), so moving one pixel to the right or down just adds a constant.
+  const float invDet = 1.0f / det;
+  const float a0dx = (p1.y - p2.y) * invDet;
+  const float a0dy = (p2.x - p1.x) * invDet;
+  const float a1dx = (p2.y - p0.y) * invDet;
+  const float a1dy = (p0.x - p2.x) * invDet;
+
+  const auto barycentrics = [&](uint32_t x, uint32_t y, float& a0, float& a1) {
+    a0 = a0dx * (x - p2.x) + a0dy * (y - p2.y);
+    a1 = a1dx * (x - p2.x) + a1dy * (y - p2.y);
+  };
+
+  const auto interpolateDepth = [&](float a0, float a1, float a2) {
+    return a0 * p0.z + a1 * p1.z + a2 * p2.z;
+  };
+  const float minVertexDepth = std::min({p0.z, p1.z, p2.z});
+  const float maxVertexDepth = std::max({p0.z, p1.z, p2.z});
+
+  // the visible pixels of a block are collected and shaded together
+  BlockPixels pixels;
+  ShadingBatch batch;
+
+  static const RasterKernels& kernels = getRasterKernels();
+  BlockSetup setup;
+  setup.a0dx = a0dx;
+  setup.a0dy = a0dy;
+  setup.a1dx = a1dx;
+  setup.a1dy = a1dy;
+  setup.epsilon = epsilon;
+  setup.z0 = p0.z;
+  setup.z1 = p1.z;
+  setup.z2 = p2.z;
+  setup.depth = nullptr;
+  setup.depthStride = depth ? depth->width : 0;
+  setup.depthLanes = 0;
+  setup.depthVisible = false;
+
+  // The blocks lie on a fixed grid of the image, so a rectangle whose edges
+  // lie on that grid covers whole blocks or the same part of a block as the
+  // bounding box, and every pixel gets the same values as without it.
+  const uint32_t firstBlockX = startX - startX % blockSize;
+  const uint32_t firstBlockY = startY - startY % blockSize;
+
+  for (uint32_t blockY = firstBlockY; blockY < endY; blockY += blockSize) {
+    const uint32_t fromY = std::max(blockY, startY);
+    const uint32_t toY = std::min(blockY + blockSize, endY) - 1;
+    for (uint32_t blockX = firstBlockX; blockX < endX; blockX += blockSize) {
+      const uint32_t fromX = std::max(blockX, startX);
+      const uint32_t toX = std::min(blockX + blockSize, endX) - 1;
+
+      // as the coordinates are linear, their extrema over the block are
+      // found at its corners
+      float a0[4], a1[4];
+      barycentrics(fromX, fromY, a0[0], a1[0]);
+      barycentrics(toX, fromY, a0[1], a1[1]);
+      barycentrics(fromX, toY, a0[2], a1[2]);
+      barycentrics(toX, toY, a0[3], a1[3]);
+
+      bool outside0 = true, outside1 = true, outside2 = true, inside = true;
+      for (size_t i = 0; i < 4; ++i) {
+        const float a2 = 1 - a0[i] - a1[i];
+        outside0 = outside0 && a0[i] < -epsilon;
+        outside1 = outside1 && a1[i] < -epsilon;
+        outside2 = outside2 && a2 < -epsilon;
+        inside = inside && a0[i] >= -epsilon && a1[i] >= -epsilon && a2 >= -epsilon;
+      }
+
+      // trivial reject: the whole block lies outside of one edge
+      if (outside0 || outside1 || outside2) continue;
+
+      // the depth is linear as well, so the triangle is hidden in the block
+      // if its largest depth there is behind everything stored for the block
+      // and visible at every pixel if its smallest depth is strictly in front
+      bool depthVisible = true;
+      if (depth) {
+        // the corners may lie outside of the triangle, limiting the range to
+        // that of the vertices keeps rounding from rejecting flat triangles
+        float minDepth = std::numeric_limits<float>::infinity();
+        float maxDepth = -std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < 4; ++i) {
+          const float z = interpolateDepth(a0[i], a1[i], 1 - a0[i] - a1[i]);
+          minDepth = std::min(minDepth, z);
+          maxDepth = std::max(maxDepth, z);
+        }
+        minDepth = std::max(minDepth, minVertexDepth);
+        maxDepth = std::min(maxDepth, maxVertexDepth);
+        if (maxDepth < depth->getBlockMin(blockX / blockSize, blockY / blockSize)) continue;
+        depthVisible = minDepth > depth->getBlockMax(blockX / blockSize, blockY / blockSize);
+      }
+
+      // the kernel evaluates the block row by row, eight pixels at a time
+      setup.blockX = blockX;
+      setup.fromY = fromY;
+      setup.rows = toY - fromY + 1;
+      setup.laneMask = ((2u << (toX - blockX)) - 1) & ~((1u << (fromX - blockX)) - 1);
+      barycentrics(blockX, fromY, setup.a0, setup.a1);
+      setup.inside = inside;
+      if (depth) {
+        setup.depth = depth->data.data() + size_t(fromY) * depth->width + blockX;
+        setup.depthLanes = (2u << (std::min(depth->width - blockX, blockSize) - 1)) - 1;
+        setup.depthVisible = depthVisible;
+      }
+
+      pixels.size = 0;
+      kernels.coverBlock(setup, pixels);
+
+      if (pixels.size == 0) continue;
+      if (depth)
+        depth->updateBlock(blockX / blockSize, blockY / blockSize);
+      shadeBlock(image, pixels, batch);
+    }
+  }
+}
+
+void Triangle::shadeBlock(Image& image, const BlockPixels& pixels,
+                          ShadingBatch& batch) const {
+  const size_t n = pixels.size;
+  const auto interpolate = [&](float val0, float val1, float val2, float* result) {
+    for (size_t i = 0; i < n; ++i)
+      result[i] = val0 * pixels.a0[i] + val1 * pixels.a1[i] + val2 * pixels.a2[i];
+  };
+  const auto interpolateVec3 = [&](const Vec3& val0, const Vec3& val1, const Vec3& val2,
+                                   float* x, float* y, float* z) {
+    interpolate(val0.x, val1.x, val2.x, x);
+    interpolate(val0.y, val1.y, val2.y, y);
+    interpolate(val0.z, val1.z, val2.z, z);
+  };
+
+  batch.size = n;
+  interpolateVec3(v0.position, v1.position, v2.position,
+                  batch.positionX, batch.positionY, batch.positionZ);
+  interpolateVec3(v0.normal, v1.normal, v2.normal,
+                  batch.normalX, batch.normalY, batch.normalZ);
+  interpolateVec3(v0.material.color_ambient, v1.material.color_ambient,
+                  v2.material.color_ambient, batch.ambientR, batch.ambientG, batch.ambientB);
+  interpolateVec3(v0.material.color_diffuse, v1.material.color_diffuse,
+                  v2.material.color_diffuse, batch.diffuseR, batch.diffuseG, batch.diffuseB);
+  interpolateVec3(v0.material.color_specular, v1.material.color_specular,
+                  v2.material.color_specular, batch.specularR, batch.specularG, batch.specularB);
+
+  shader.shadeBatch(batch);
+
+  // the same conversion as Image::setNormalizedValue, for all pixels at once
+  const auto toByte = [](float value) {
+    return uint8_t(std::max(0.0f, std::min(1.0f, value)) * 255);
+  };
+  for (size_t i = 0; i < n; ++i) {
+    uint8_t* pixel = image.data.data() + image.computeIndex(pixels.x[i], pixels.y[i], 0);
+    pixel[0] = toByte(batch.red[i]);
+    pixel[1] = toByte(batch.green[i]);
+    pixel[2] = toByte(batch.blue[i]);
+    if (image.componentCount > 3)
+      pixel[3] = 255;
+  }
+}
@@ -2,21 +2,53 @@
 
 #include "Vertex.h"
 #include "Image.h"
+#include "DepthBuffer.h"
 #include "Shader.h"
 
+struct BlockPixels;
+
 class Triangle {
 private:
 	Vertex v0, v1, v2;
 	const Shader& shader;
 
-  Vec3 interpolate(const Vec3& val0, float a0,
-                   const Vec3& val1, float a1,
-                   const Vec3& val2, float a2);
+  void shadeBlock(Image& image, const BlockPixels& pixels,
+                  ShadingBatch& batch) const;
 
 public:
+  /**
+   * Edge length of the square pixel blocks that are tested against the
+   * triangle as a whole before any pixel inside them is looked at. The
+   * blocks lie on a fixed grid of the image, the one of the depth buffer.
+   */
+  static constexpr uint32_t blockSize = DepthBuffer::blockSize;
+
   Triangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
            const Shader& s);
-	void draw(Image& image);
+  /**
+   * Draws the triangle into the image. With a depth buffer a pixel is only
+   * shaded and written if the triangle is not behind the value stored for
+   * it (on equal values the triangle drawn last wins), blocks of pixels the
+   * triangle is hidden in are skipped as a whole. Without one, every covered
+   * pixel is overwritten.
+   */
+	void draw(Image& image, DepthBuffer* depth = nullptr) const;
+
+  /**
+   * Draws only the pixels of the triangle inside the rectangle
+   * [x0, x1) x [y0, y1) of the image. If the edges of the rectangle lie on
+   * multiples of blockSize, the pixels are exactly the same as those drawn
+   * by draw(image, depth).
+   */
+  void draw(Image& image, DepthBuffer* depth, uint32_t x0, uint32_t y0,
+            uint32_t x1, uint32_t y1) const;
+
+  /**
+   * Computes the rectangle [x0, x1) x [y0, y1) of pixels of the image the
+   * triangle may cover, returns false if it covers none.
+   */
+  bool getBounds(const Image& image, uint32_t& x0, uint32_t& y0,
+                 uint32_t& x1, uint32_t& y1) const;
 
 };
 
@@ -1,6 +1,11 @@
 #include <GLApp.h>
+#include <OBJFile.h>
+
+#include <cmath>
+#include <optional>
 
 #include "Triangle.h"
+#include "TiledRasterizer.h"
 #include "AmbientShader.h"
 #include "DiffuseShader.h"
 #include "PhongShader.h"
@@ -10,12 +15,22 @@ class MyGLApp : public GLApp
 {
 public:
   Image image{ 600, 600 };
+  DepthBuffer depth{ image };
+  TiledRasterizer rasterizer;
+  std::string objFile;  // OBJ mesh given on the command line, drawn instead of the triangles
+  std::optional<OBJFile> mesh;
+  const DiffuseShader meshShader{ Vec3{ 300, 300, 1000 }, Vec3{ 1, 1, 1 } };
 
   MyGLApp() : GLApp{ 600, 600, 1, "Phong Lighting" } {}
 
   virtual void init() override {
     GL(glDisable(GL_CULL_FACE));
 
+    if (!objFile.empty()) {
+      mesh.emplace(objFile, true);
+      return;
+    }
+
     // define some materials for our triangles
     const Material red{ Vec3{1, 0, 0} };
     const Material green{ Vec3{0, 1, 0} };
@@ -30,9 +45,9 @@ public:
     // create a simple shader for the first triangle
     const AmbientShader as{};
 
-    // create and draw the first triangle
-    Triangle triangle1(v0, v1, v2, as);
-    triangle1.draw(image);
+    // create the first triangle, all triangles are drawn together at the end
+    std::vector<Triangle> triangles;
+    triangles.emplace_back(v0, v1, v2, as);
 
     // define new vertices for the second triangle
     const Vertex d0{ Vec3{12, 384, 0}, lightOrange };
@@ -44,9 +59,8 @@ public:
     Vec3 light_diffuse_color{ 1, 1, 1 };
     const DiffuseShader diffuseShader{ lightPos, light_diffuse_color };
 
-    // create and draw the diffuse shaded triangle
-    Triangle triangle2(d0, d1, d2, diffuseShader);
-    triangle2.draw(image);
+    // create the diffuse shaded triangle
+    triangles.emplace_back(d0, d1, d2, diffuseShader);
 
     // create a new vertex for the third triangle
     const Vertex v3{ Vec3{36, 60, 0}, blue };
@@ -59,18 +73,16 @@ public:
     lightPos = Vec3{ 0, 0, 500 };
     const PhongShader phongShader{ viewer, lightPos, light_ambient_color, light_diffuse_color, light_specular_color, 20 };
 
-    // create and draw the phong shaded triangle
-    Triangle triangle3(v0, v2, v3, phongShader);
-    triangle3.draw(image);
+    // create the phong shaded triangle
+    triangles.emplace_back(v0, v2, v3, phongShader);
 
     // define new vertices with custom normals for the fourth triangle
     const Vertex a{ Vec3{264, 588, 0}, red, Vec3{-1, -1, 1} };
     const Vertex b{ Vec3{588, 588, 0}, red, Vec3{0.5f, 0.5f, 1} };
     const Vertex c{ Vec3{588, 372, 0}, red, Vec3{-1, -1, 1} };
 
-    // create and draw the red phong shaded triangle
-    Triangle triangle4(a, b, c, phongShader);
-    triangle4.draw(image);
+    // create the red phong shaded triangle
+    triangles.emplace_back(a, b, c, phongShader);
 
     // define a new vertex for the fifth triangle
     Vertex v4(Vec3(588, 360, 0), green);
@@ -78,9 +90,47 @@ public:
     // create a bump shader for the fifth triangle
     BumpPhongShader bump(phongShader, 50, 0.3f);
 
-    // create and draw the bump-phong shaded triangle
-    Triangle triangle5(v1, v4, v2, bump);
-    triangle5.draw(image);
+    // create the bump-phong shaded triangle
+    triangles.emplace_back(v1, v4, v2, bump);
+
+    // draw all triangles in the order they were created
+    rasterizer.draw(triangles, image);
+  }
+
+  virtual void animate(double animationTime) override {
+    if (mesh)
+      drawMesh(float(animationTime));
+  }
+
+  // draws the mesh spinning around the y axis, triangles facing away from
+  // the viewer are skipped before they reach the depth test
+  void drawMesh(float angle) {
+    const float cosAngle = std::cos(angle);
+    const float sinAngle = std::sin(angle);
+    const float scale = 0.9f * std::min(image.width, image.height);
+    const Vec3 center{ image.width / 2.0f, image.height / 2.0f, 0 };
+    const Material material{ Vec3{1, 0.765f, 0.482f } };
+
+    auto toVertex = [&](size_t i) {
+      const Vec3& p = mesh->vertices[i];
+      const Vec3& n = mesh->normals[i];
+      return Vertex{ Vec3{ cosAngle * p.x + sinAngle * p.z, p.y, cosAngle * p.z - sinAngle * p.x } * scale + center,
+                     material, Vec3{ cosAngle * n.x + sinAngle * n.z, n.y, cosAngle * n.z - sinAngle * n.x } };
+    };
+
+    std::vector<Triangle> triangles;
+    triangles.reserve(mesh->indices.size());
+    for (const OBJFile::IndexType& index : mesh->indices) {
+      const Vertex a = toVertex(index[0]);
+      const Vertex b = toVertex(index[1]);
+      const Vertex c = toVertex(index[2]);
+      if (Vec3::cross(b.position - a.position, c.position - a.position).z > 0)
+        triangles.emplace_back(a, b, c, meshShader);
+    }
+
+    std::fill(image.data.begin(), image.data.end(), 0);
+    depth.clear();
+    rasterizer.draw(triangles, image, &depth);
   }
 
   virtual void draw() override {
@@ -98,6 +148,8 @@ INT WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nC
 int main(int argc, char** argv) {
     std::vector<std::string> args{ argv + 1, argv + argc };
 #endif
+    if (!args.empty())
+        myApp.objFile = args[0];
     try {
         myApp.run();
     }
@@ -0,0 +1,81 @@
+#pragma once
+#include <Vec3.h>
+#include <algorithm>
+#include <limits>
+
+#include "Ray.h"
+
+/// <summary>
+/// Axis aligned bounding box, an empty box has min > max.
+/// </summary>
+struct AABB
+{
+	Vec3 min{ std::numeric_limits<float>::max() };
+	Vec3 max{ std::numeric_limits<float>::lowest() };
+
+	AABB() = default;
+
+	AABB(const Vec3& min, const Vec3& max)
+		: min(min), max(max)
+	{ }
+
+	void extend(const Vec3& p)
+	{
+		min = Vec3::minV(min, p);
+		max = Vec3::maxV(max, p);
+	}
+
+	void extend(const AABB& other)
+	{
+		min = Vec3::minV(min, other.min);
+		max = Vec3::maxV(max, other.max);
+	}
+
+	bool isEmpty() const
+	{
+		return min.x > max.x || min.y > max.y || min.z > max.z;
+	}
+
+	Vec3 center() const
+	{
+		return (min + max) * 0.5f;
+	}
+
+	Vec3 extent() const
+	{
+		return max - min;
+	}
+
+	float surfaceArea() const
+	{
+		if (isEmpty())
+			return 0.0f;
+		const Vec3 e = extent();
+		return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+	}
+
+	/// <summary>
+	/// Slab test against the ray segment [0, tMax], invDir holds the reciprocal ray direction.
+	/// On a hit tNear receives the distance at which the ray enters the box.
+	/// </summary>
+	bool intersect(const Vec3& origin, const Vec3& invDir, float tMax, float& tNear) const
+	{
+		float t0 = 0.0f;
+		float t1 = tMax;
+		for (int a = 0; a < 3; ++a)
+		{
+			float tA = (min.e[a] - origin.e[a]) * invDir.e[a];
+			float tB = (max.e[a] - origin.e[a]) * invDir.e[a];
+			if (tA > tB)
+				std::swap(tA, tB);
+			// widen the far distance slightly so rounding never culls a surface lying on the box
+			tB *= 1.0f + 2.0f * std::numeric_limits<float>::epsilon();
+			t0 = tA > t0 ? tA : t0;
+			t1 = tB < t1 ? tB : t1;
+			if (t0 > t1)
+				return false;
+		}
+		tNear = t0;
+		return true;
+	}
+};
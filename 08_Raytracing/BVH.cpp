@@ -0,0 +1,205 @@
+#include "BVH.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <utility>
+
+BVH::BVH(const std::vector<AABB>& primitiveBounds)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	std::vector<BuildPrimitive> primitives;
+	primitives.reserve(primitiveBounds.size());
+	for (uint32_t i = 0; i < uint32_t(primitiveBounds.size()); ++i)
+		primitives.push_back(BuildPrimitive{ primitiveBounds[i], primitiveBounds[i].center(), i });
+
+	buildStats.primitiveCount = primitives.size();
+	if (!primitives.empty())
+	{
+		nodes.reserve(2 * primitives.size());
+		primitiveIndices.reserve(primitives.size());
+		build(primitives, 0, uint32_t(primitives.size()), 0);
+	}
+
+	// compute the SAH cost of the final tree relative to the root box
+	const float rootArea = nodes.empty() ? 0.0f : nodes[0].bounds.surfaceArea();
+	for (const BVHNode& node : nodes)
+	{
+		const float p = rootArea > 0.0f ? node.bounds.surfaceArea() / rootArea : 1.0f;
+		if (node.count > 0)
+			buildStats.sahCost += p * node.count * INTERSECTION_COST;
+		else
+			buildStats.sahCost += p * TRAVERSAL_COST;
+	}
+	buildStats.nodeCount = nodes.size();
+
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+	buildStats.buildMilliseconds = duration.count();
+}
+
+BVH::BVH(std::vector<BVHNode> nodes, std::vector<uint32_t> primitiveIndices, const BVHBuildStats& buildStats)
+	: nodes(std::move(nodes)), primitiveIndices(std::move(primitiveIndices)), buildStats(buildStats)
+{
+	this->buildStats.buildMilliseconds = 0.0;
+}
+
+bool BVH::isValid(size_t primitiveCount) const
+{
+	if (primitiveIndices.size() != primitiveCount)
+		return false;
+	for (uint32_t index : primitiveIndices)
+		if (index >= primitiveCount)
+			return false;
+
+	// both children of a node lie behind it, so the hierarchy has no cycles
+	// and the depth of every node is known before its children are checked
+	std::vector<uint32_t> depth(nodes.size(), 0);
+	size_t leafPrimitives = 0;
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		const BVHNode& node = nodes[i];
+		if (node.count > 0)
+		{
+			if (node.offset > primitiveIndices.size() || node.count > primitiveIndices.size() - node.offset)
+				return false;
+			leafPrimitives += node.count;
+		}
+		else
+		{
+			if (node.axis > 2 || node.offset <= i + 1 || node.offset >= nodes.size() || depth[i] + 2 >= STACK_SIZE)
+				return false;
+			depth[i + 1] = std::max(depth[i + 1], depth[i] + 1);
+			depth[node.offset] = std::max(depth[node.offset], depth[i] + 1);
+		}
+	}
+
+	// the leaves hold every primitive, a leaf count that did not fit into
+	// 16 bits would have dropped some
+	return leafPrimitives == primitiveIndices.size();
+}
+
+uint32_t BVH::makeLeaf(std::vector<BuildPrimitive>& primitives, uint32_t first, uint32_t count, const AABB& bounds)
+{
+	const uint32_t nodeIndex = uint32_t(nodes.size());
+	nodes.push_back(BVHNode{ bounds, uint32_t(primitiveIndices.size()), uint16_t(count), 0 });
+	for (uint32_t i = first; i < first + count; ++i)
+		primitiveIndices.push_back(primitives[i].index);
+
+	buildStats.leafCount++;
+	buildStats.maxLeafSize = std::max(buildStats.maxLeafSize, count);
+	return nodeIndex;
+}
+
+uint32_t BVH::build(std::vector<BuildPrimitive>& primitives, uint32_t first, uint32_t count, uint32_t depth)
+{
+	buildStats.maxDepth = std::max(buildStats.maxDepth, depth);
+
+	AABB bounds;
+	AABB centerBounds;
+	for (uint32_t i = first; i < first + count; ++i)
+	{
+		bounds.extend(primitives[i].bounds);
+		centerBounds.extend(primitives[i].center);
+	}
+
+	// the stack used during traversal limits the depth of the tree
+	if (count == 1 || depth + 2 >= STACK_SIZE)
+		return makeLeaf(primitives, first, count, bounds);
+
+	// leaves store their count in 16 bits, so nodes too large to end up in
+	// such leaves within the remaining levels are split at the median
+	const uint32_t levelsLeft = STACK_SIZE - 3 - depth;
+	const bool splitAtMedian = levelsLeft < 32 && uint64_t(count) > (uint64_t(UINT16_MAX) << levelsLeft);
+
+	const Vec3 centerExtent = centerBounds.extent();
+	uint32_t axis = 0;
+	if (centerExtent.y > centerExtent.e[axis]) axis = 1;
+	if (centerExtent.z > centerExtent.e[axis]) axis = 2;
+
+	// all centers coincide, no split plane can separate the primitives
+	if (centerExtent.e[axis] <= 0.0f)
+	{
+		if (count <= UINT16_MAX)
+			return makeLeaf(primitives, first, count, bounds);
+	}
+
+	uint32_t mid = first;
+	if (centerExtent.e[axis] > 0.0f && !splitAtMedian)
+	{
+		// bin the primitive centers along the split axis and evaluate the SAH for every bin border
+		struct Bin
+		{
+			AABB bounds;
+			uint32_t count = 0;
+		};
+		std::array<Bin, BIN_COUNT> bins{};
+		const float binScale = float(BIN_COUNT) / centerExtent.e[axis];
+		auto binIndex = [&](const BuildPrimitive& p)
+		{
+			const uint32_t b = uint32_t((p.center.e[axis] - centerBounds.min.e[axis]) * binScale);
+			return std::min(b, BIN_COUNT - 1);
+		};
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			Bin& bin = bins[binIndex(primitives[i])];
+			bin.bounds.extend(primitives[i].bounds);
+			bin.count++;
+		}
+
+		std::array<float, BIN_COUNT - 1> leftArea{};
+		std::array<uint32_t, BIN_COUNT - 1> leftCount{};
+		AABB leftBounds;
+		uint32_t leftSum = 0;
+		for (uint32_t b = 0; b < BIN_COUNT - 1; ++b)
+		{
+			leftBounds.extend(bins[b].bounds);
+			leftSum += bins[b].count;
+			leftArea[b] = leftBounds.surfaceArea();
+			leftCount[b] = leftSum;
+		}
+
+		const float nodeArea = bounds.surfaceArea();
+		float bestCost = std::numeric_limits<float>::max();
+		uint32_t bestSplit = 0;
+		AABB rightBounds;
+		uint32_t rightSum = 0;
+		for (uint32_t b = BIN_COUNT - 1; b > 0; --b)
+		{
+			rightBounds.extend(bins[b].bounds);
+			rightSum += bins[b].count;
+			if (leftCount[b - 1] == 0 || rightSum == 0)
+				continue;
+			const float cost = TRAVERSAL_COST + INTERSECTION_COST *
+				(leftArea[b - 1] * leftCount[b - 1] + rightBounds.surfaceArea() * rightSum) / nodeArea;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = b;
+			}
+		}
+
+		const float leafCost = INTERSECTION_COST * count;
+		if (bestCost >= leafCost && count <= MAX_LEAF_SIZE)
+			return makeLeaf(primitives, first, count, bounds);
+
+		if (bestSplit > 0)
+		{
+			mid = uint32_t(std::partition(primitives.begin() + first, primitives.begin() + first + count,
+				[&](const BuildPrimitive& p) { return binIndex(p) < bestSplit; }) - primitives.begin());
+		}
+	}
+
+	// degenerate partition, fall back to splitting at the median
+	if (mid == first || mid == first + count)
+	{
+		mid = first + count / 2;
+		std::nth_element(primitives.begin() + first, primitives.begin() + mid, primitives.begin() + first + count,
+			[&](const BuildPrimitive& a, const BuildPrimitive& b) { return a.center.e[axis] < b.center.e[axis]; });
+	}
+
+	const uint32_t nodeIndex = uint32_t(nodes.size());
+	nodes.push_back(BVHNode{ bounds, 0, 0, uint16_t(axis) });
+	build(primitives, first, mid - first, depth + 1);
+	nodes[nodeIndex].offset = build(primitives, mid, first + count - mid, depth + 1);
+	return nodeIndex;
+}
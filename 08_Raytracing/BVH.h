@@ -0,0 +1,205 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "AABB.h"
+#include "PacketKernels.h"
+#include "Ray.h"
+
+/// <summary>
+/// Node of the flattened hierarchy. Nodes are stored in depth first order, so
+/// the first child of an interior node directly follows its parent and only
+/// the index of the second child has to be stored.
+/// </summary>
+struct BVHNode
+{
+	AABB bounds;
+	uint32_t offset;	// leaf: first entry in primitiveIndices, interior: index of the second child
+	uint16_t count;		// number of primitives, 0 for interior nodes
+	uint16_t axis;		// split axis of interior nodes
+};
+
+/// <summary>
+/// Quality figures of a built hierarchy. sahCost is the expected cost of a
+/// random ray in units of one primitive test (lower is better).
+/// </summary>
+struct BVHBuildStats
+{
+	size_t primitiveCount = 0;
+	size_t nodeCount = 0;
+	size_t leafCount = 0;
+	uint32_t maxDepth = 0;
+	uint32_t maxLeafSize = 0;
+	float sahCost = 0.0f;
+	double buildMilliseconds = 0.0;
+};
+
+struct BVHTraversalStats
+{
+	uint64_t nodesVisited = 0;
+	uint64_t primitivesTested = 0;
+};
+
+/// <summary>
+/// Bounding volume hierarchy over an arbitrary set of boxes built with the
+/// surface area heuristic. The hierarchy only knows primitive indices, the
+/// actual intersection tests are supplied by the caller during traversal.
+/// </summary>
+class BVH
+{
+private:
+	static constexpr uint32_t BIN_COUNT = 16;
+	static constexpr uint32_t MAX_LEAF_SIZE = 4;
+	static constexpr float TRAVERSAL_COST = 1.0f;
+	static constexpr float INTERSECTION_COST = 1.0f;
+	static constexpr uint32_t STACK_SIZE = 64;
+
+	std::vector<BVHNode> nodes;
+	std::vector<uint32_t> primitiveIndices;
+	BVHBuildStats buildStats;
+
+public:
+	BVH() = default;
+	explicit BVH(const std::vector<AABB>& primitiveBounds);
+
+	/// <summary>
+	/// Adopts a hierarchy that was built before, e.g. one read from a scene file.
+	/// </summary>
+	BVH(std::vector<BVHNode> nodes, std::vector<uint32_t> primitiveIndices, const BVHBuildStats& buildStats);
+
+	/// <summary>
+	/// Checks that an adopted hierarchy can be traversed without leaving its
+	/// arrays or the traversal stack and that its leaves hold all of the
+	/// primitiveCount primitives.
+	/// </summary>
+	bool isValid(size_t primitiveCount) const;
+
+	bool isEmpty() const { return nodes.empty(); }
+	const std::vector<BVHNode>& getNodes() const { return nodes; }
+	const std::vector<uint32_t>& getPrimitiveIndices() const { return primitiveIndices; }
+	const BVHBuildStats& getBuildStats() const { return buildStats; }
+
+	/// <summary>
+	/// Visits all primitives whose boxes are hit by the ray segment [0, tMax],
+	/// nearer subtrees first. test(primitive, tMax) is called for every
+	/// candidate; it may shrink tMax to prune the remaining traversal and
+	/// returns true to stop the traversal altogether.
+	/// </summary>
+	template <typename PrimitiveTest>
+	void traverse(const Ray& ray, float tMax, PrimitiveTest&& test, BVHTraversalStats* stats = nullptr) const
+	{
+		if (nodes.empty())
+			return;
+
+		const Vec3 origin = ray.getOrigin();
+		const Vec3 dir = ray.getDirection();
+		const Vec3 invDir{ 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z };
+
+		uint32_t stack[STACK_SIZE];
+		uint32_t stackSize = 0;
+		uint32_t current = 0;
+		while (true)
+		{
+			const BVHNode& node = nodes[current];
+			if (stats) ++stats->nodesVisited;
+
+			float tNear;
+			if (node.bounds.intersect(origin, invDir, tMax, tNear))
+			{
+				if (node.count > 0)
+				{
+					for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+					{
+						if (stats) ++stats->primitivesTested;
+						if (test(primitiveIndices[i], tMax))
+							return;
+					}
+				}
+				else if (dir.e[node.axis] < 0)
+				{
+					stack[stackSize++] = current + 1;
+					current = node.offset;
+					continue;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					current = current + 1;
+					continue;
+				}
+			}
+
+			if (stackSize == 0)
+				return;
+			current = stack[--stackSize];
+		}
+	}
+
+	/// <summary>
+	/// Packet version of traverse. A node is entered if its box is hit by any
+	/// active lane. test(primitive, mask) receives the lanes that reached the
+	/// leaf and returns the lanes that are done, these take no further part in
+	/// the traversal. tMax is read at every box test, so test may shrink it.
+	/// </summary>
+	template <typename PacketTest>
+	void traversePacket(const RayPacket& packet, uint32_t mask, const float* tMax, const PacketKernels& kernels, PacketTest&& test) const
+	{
+		if (nodes.empty() || mask == 0)
+			return;
+
+		// the first active lane decides the child order for the whole packet
+		uint32_t lead = 0;
+		while (!(mask & (1u << lead)))
+			++lead;
+		const float dir[3] = { packet.dx[lead], packet.dy[lead], packet.dz[lead] };
+
+		uint32_t stack[STACK_SIZE];
+		uint32_t stackSize = 0;
+		uint32_t current = 0;
+		uint32_t active = mask;
+		while (true)
+		{
+			const BVHNode& node = nodes[current];
+			const uint32_t hitMask = kernels.intersectBox(packet, active, node.bounds, tMax);
+			if (hitMask != 0)
+			{
+				if (node.count > 0)
+				{
+					for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+					{
+						active &= ~test(primitiveIndices[i], hitMask & active);
+						if (active == 0)
+							return;
+					}
+				}
+				else if (dir[node.axis] < 0)
+				{
+					stack[stackSize++] = current + 1;
+					current = node.offset;
+					continue;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					current = current + 1;
+					continue;
+				}
+			}
+
+			if (stackSize == 0)
+				return;
+			current = stack[--stackSize];
+		}
+	}
+
+private:
+	struct BuildPrimitive
+	{
+		AABB bounds;
+		Vec3 center;
+		uint32_t index;
+	};
+
+	uint32_t build(std::vector<BuildPrimitive>& primitives, uint32_t first, uint32_t count, uint32_t depth);
+	uint32_t makeLeaf(std::vector<BuildPrimitive>& primitives, uint32_t first, uint32_t count, const AABB& bounds);
+};
@@ -0,0 +1,249 @@
+#include "CompiledScene.h"
+#include "Plane.h"
+#include "Sphere.h"
+
+#include <algorithm>
+#include <cmath>
+
+void CompiledScene::build(const std::vector<std::shared_ptr<const IntersectableObject>>& objects,
+                          const std::vector<uint32_t>& materialIDs, const std::vector<Material>& materials)
+{
+	spheres = SphereArrays{};
+	planes = PlaneArrays{};
+	genericObjects.clear();
+	genericObjectIndices.clear();
+	genericMaterial.clear();
+	primitives.clear();
+	shadowCasters.clear();
+
+	for (uint32_t i = 0; i < uint32_t(objects.size()); ++i)
+	{
+		const IntersectableObject* object = objects[i].get();
+		const uint32_t material = materialIDs[i];
+		const uint8_t shadowCaster = materials[material].isShadowCaster() ? 1 : 0;
+		shadowCasters.push_back(shadowCaster);
+
+		if (const Sphere* sphere = dynamic_cast<const Sphere*>(object))
+		{
+			const Vec3 center = sphere->getCenter();
+			primitives.push_back({ PrimitiveKind::SPHERE, uint32_t(spheres.object.size()) });
+			spheres.centerX.push_back(center.x);
+			spheres.centerY.push_back(center.y);
+			spheres.centerZ.push_back(center.z);
+			spheres.sqradius.push_back(sphere->getSqRadius());
+			spheres.object.push_back(i);
+			spheres.material.push_back(material);
+			spheres.shadowCaster.push_back(shadowCaster);
+		}
+		else if (const Plane* plane = dynamic_cast<const Plane*>(object))
+		{
+			const Vec3 normal = plane->getNormal();
+			primitives.push_back({ PrimitiveKind::PLANE, uint32_t(planes.object.size()) });
+			planes.normalX.push_back(normal.x);
+			planes.normalY.push_back(normal.y);
+			planes.normalZ.push_back(normal.z);
+			planes.d.push_back(plane->getD());
+			planes.object.push_back(i);
+			planes.material.push_back(material);
+			planes.shadowCaster.push_back(shadowCaster);
+		}
+		else
+		{
+			primitives.push_back({ PrimitiveKind::GENERIC, uint32_t(genericObjects.size()) });
+			genericObjects.push_back(object);
+			genericObjectIndices.push_back(i);
+			genericMaterial.push_back(material);
+		}
+	}
+}
+
+CompiledHit CompiledScene::intersect(const Ray& ray, bool shadowRay) const
+{
+	const Vec3 o = ray.getOrigin();
+	const Vec3 dir = ray.getDirection();
+	CompiledHit result;
+
+	// the slots of each kind are sorted by object index, so within a loop a
+	// strictly closer hit is required and only hits of different kinds need
+	// the explicit tie break
+	auto merge = [&result](float t, int32_t object) {
+		if (object < 0)
+			return false;
+		if (result.object < 0 || t < result.t || (t == result.t && object < result.object))
+		{
+			result.t = t;
+			result.object = object;
+			return true;
+		}
+		return false;
+	};
+
+	{
+		float bestT = std::numeric_limits<float>::max();
+		int32_t best = -1;
+		const uint32_t count = uint32_t(spheres.object.size());
+		for (uint32_t k = 0; k < count; ++k)
+		{
+			const float lx = spheres.centerX[k] - o.x;
+			const float ly = spheres.centerY[k] - o.y;
+			const float lz = spheres.centerZ[k] - o.z;
+			const float tCenter = lx * dir.x + ly * dir.y + lz * dir.z;
+			const float dSq = (lx * lx + ly * ly + lz * lz) - tCenter * tCenter;
+			const float dist = std::sqrt(std::max(0.0f, spheres.sqradius[k] - dSq));
+			const float tNear = tCenter - dist;
+			const float t = tNear < 0 ? tCenter + dist : tNear;
+			const bool valid = !(tCenter < 0) & !(dSq > spheres.sqradius[k]) & (!shadowRay | (spheres.shadowCaster[k] != 0));
+			const bool closer = valid & ((best < 0) | (t < bestT));
+			bestT = closer ? t : bestT;
+			best = closer ? int32_t(k) : best;
+		}
+		if (best >= 0)
+			merge(bestT, int32_t(spheres.object[best]));
+	}
+
+	{
+		float bestT = std::numeric_limits<float>::max();
+		int32_t best = -1;
+		const uint32_t count = uint32_t(planes.object.size());
+		for (uint32_t k = 0; k < count; ++k)
+		{
+			const float denom = dir.x * planes.normalX[k] + dir.y * planes.normalY[k] + dir.z * planes.normalZ[k];
+			const float t = -((o.x * planes.normalX[k] + o.y * planes.normalY[k] + o.z * planes.normalZ[k]) + planes.d[k]) / denom;
+			const bool valid = (denom != 0.0f) & !(t < 0) & (!shadowRay | (planes.shadowCaster[k] != 0));
+			const bool closer = valid & ((best < 0) | (t < bestT));
+			bestT = closer ? t : bestT;
+			best = closer ? int32_t(k) : best;
+		}
+		if (best >= 0)
+			merge(bestT, int32_t(planes.object[best]));
+	}
+
+	for (uint32_t k = 0; k < uint32_t(genericObjects.size()); ++k)
+	{
+		const uint32_t object = genericObjectIndices[k];
+		if (shadowRay && !shadowCasters[object])
+			continue;
+		std::optional<Intersection> i = genericObjects[k]->intersect(ray);
+		if (i.has_value() && merge(i->getT(), int32_t(object)))
+			result.intersection = i;
+	}
+
+	return result;
+}
+
+bool CompiledScene::occluded(const Ray& ray, float maxT) const
+{
+	const Vec3 o = ray.getOrigin();
+	const Vec3 dir = ray.getDirection();
+
+	bool hit = false;
+	const uint32_t sphereCount = uint32_t(spheres.object.size());
+	for (uint32_t k = 0; k < sphereCount && !hit; ++k)
+	{
+		const float lx = spheres.centerX[k] - o.x;
+		const float ly = spheres.centerY[k] - o.y;
+		const float lz = spheres.centerZ[k] - o.z;
+		const float tCenter = lx * dir.x + ly * dir.y + lz * dir.z;
+		const float dSq = (lx * lx + ly * ly + lz * lz) - tCenter * tCenter;
+		const float dist = std::sqrt(std::max(0.0f, spheres.sqradius[k] - dSq));
+		const float tNear = tCenter - dist;
+		const float t = tNear < 0 ? tCenter + dist : tNear;
+		hit = !(tCenter < 0) & !(dSq > spheres.sqradius[k]) & (t <= maxT) & (spheres.shadowCaster[k] != 0);
+	}
+
+	const uint32_t planeCount = uint32_t(planes.object.size());
+	for (uint32_t k = 0; k < planeCount && !hit; ++k)
+	{
+		const float denom = dir.x * planes.normalX[k] + dir.y * planes.normalY[k] + dir.z * planes.normalZ[k];
+		const float t = -((o.x * planes.normalX[k] + o.y * planes.normalY[k] + o.z * planes.normalZ[k]) + planes.d[k]) / denom;
+		hit = (denom != 0.0f) & (t >= 0) & (t <= maxT) & (planes.shadowCaster[k] != 0);
+	}
+
+	for (uint32_t k = 0; k < uint32_t(genericObjects.size()) && !hit; ++k)
+		hit = shadowCasters[genericObjectIndices[k]] && genericObjects[k]->hits(ray, maxT);
+
+	return hit;
+}
+
+bool CompiledScene::intersectSphere(uint32_t slot, const Ray& ray, float& t) const
+{
+	const Vec3 l = getSphereCenter(slot) - ray.getOrigin();
+
+	const float tCenter = Vec3::dot(l, ray.getDirection());
+	if (tCenter < 0)
+		return false;
+
+	const float dSq = l.sqlength() - tCenter * tCenter;
+	if (dSq > spheres.sqradius[slot])
+		return false;
+
+	const float dist = std::sqrt(spheres.sqradius[slot] - dSq);
+	t = tCenter - dist;
+	if (t < 0)
+		t = tCenter + dist;	// when inside sphere
+	return true;
+}
+
+bool CompiledScene::intersectPlane(uint32_t slot, const Ray& ray, float& t) const
+{
+	const Vec3 normal = getPlaneNormal(slot);
+	const float denom = Vec3::dot(ray.getDirection(), normal);
+	if (denom == 0.0f)
+		return false;
+
+	t = -(Vec3::dot(ray.getOrigin(), normal) + planes.d[slot]) / denom;
+	return true;
+}
+
+bool CompiledScene::intersect(uint32_t object, const Ray& ray, float& t, std::optional<Intersection>& intersection) const
+{
+	const PrimitiveRef p = primitives[object];
+	switch (p.kind) {
+		case PrimitiveKind::SPHERE:
+			return intersectSphere(p.slot, ray, t);
+		case PrimitiveKind::PLANE:
+			return intersectPlane(p.slot, ray, t) && !(t < 0);
+		default:
+		{
+			intersection = genericObjects[p.slot]->intersect(ray);
+			if (!intersection.has_value())
+				return false;
+			t = intersection->getT();
+			return true;
+		}
+	}
+}
+
+bool CompiledScene::hits(uint32_t object, const Ray& ray, float tMax) const
+{
+	const PrimitiveRef p = primitives[object];
+	float t;
+	switch (p.kind) {
+		case PrimitiveKind::SPHERE:
+			return intersectSphere(p.slot, ray, t) && t <= tMax;
+		case PrimitiveKind::PLANE:
+			return intersectPlane(p.slot, ray, t) && t >= 0 && t <= tMax;
+		default:
+			return genericObjects[p.slot]->hits(ray, tMax);
+	}
+}
+
+std::optional<Intersection> CompiledScene::makeIntersection(uint32_t object, const Ray& ray, float t,
+                                                            std::optional<Intersection> intersection) const
+{
+	const PrimitiveRef p = primitives[object];
+	switch (p.kind) {
+		case PrimitiveKind::SPHERE:
+		{
+			Vec3 normal = ray.getPosOnRay(t) - getSphereCenter(p.slot);
+			normal = Vec3::normalize(normal);
+			return Intersection{ spheres.material[p.slot], normal, t };
+		}
+		case PrimitiveKind::PLANE:
+			return Intersection{ planes.material[p.slot], getPlaneNormal(p.slot), t };
+		default:
+			if (intersection.has_value())
+				intersection->setMaterialID(genericMaterial[p.slot]);
+			return intersection;
+	}
+}
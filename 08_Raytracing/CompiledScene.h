@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "IntersectableObject.h"
+#include "Intersection.h"
+#include "Material.h"
+#include "Ray.h"
+
+enum class PrimitiveKind : uint8_t {
+	SPHERE, PLANE, GENERIC
+};
+
+/// <summary>
+/// Where an object ended up in the compiled scene: its kind and its slot in
+/// the arrays of that kind.
+/// </summary>
+struct PrimitiveRef
+{
+	PrimitiveKind kind;
+	uint32_t slot;
+};
+
+/// <summary>
+/// Closest hit found in the compiled scene, object is the index of the object
+/// in the order it was added to the scene or -1 if nothing was hit. For
+/// GENERIC objects the record their test returned is kept, so that it does
+/// not have to be computed again for the closest hit.
+/// </summary>
+struct CompiledHit
+{
+	float t = std::numeric_limits<float>::max();
+	int32_t object = -1;
+	std::optional<Intersection> intersection;
+};
+
+/// <summary>
+/// Flat copy of the scene objects for the intersection loops. Spheres and
+/// planes are stored as structure of arrays, so the loops run over
+/// contiguous floats without virtual calls or reference counting. Objects of
+/// any other type are kept as plain pointers and tested through their
+/// virtual methods, they remain owned by the Scene. The compiled tests use
+/// the same arithmetic as Sphere and Plane and therefore find the same hits.
+/// </summary>
+class CompiledScene
+{
+private:
+	struct SphereArrays
+	{
+		std::vector<float> centerX;
+		std::vector<float> centerY;
+		std::vector<float> centerZ;
+		std::vector<float> sqradius;
+		std::vector<uint32_t> object;
+		std::vector<uint32_t> material;
+		std::vector<uint8_t> shadowCaster;
+	};
+
+	struct PlaneArrays
+	{
+		std::vector<float> normalX;
+		std::vector<float> normalY;
+		std::vector<float> normalZ;
+		std::vector<float> d;
+		std::vector<uint32_t> object;
+		std::vector<uint32_t> material;
+		std::vector<uint8_t> shadowCaster;
+	};
+
+	SphereArrays spheres;
+	PlaneArrays planes;
+	std::vector<const IntersectableObject*> genericObjects;
+	std::vector<uint32_t> genericObjectIndices;
+	std::vector<uint32_t> genericMaterial;
+	std::vector<PrimitiveRef> primitives;	// indexed by object
+	std::vector<uint8_t> shadowCasters;		// indexed by object
+
+public:
+	/// <summary>
+	/// Rebuilds all arrays from the objects, the order of objects defines the
+	/// object indices. materialIDs holds the index of every object's material
+	/// in materials, the material table of the Scene.
+	/// </summary>
+	void build(const std::vector<std::shared_ptr<const IntersectableObject>>& objects,
+	           const std::vector<uint32_t>& materialIDs, const std::vector<Material>& materials);
+
+	size_t getObjectCount() const { return primitives.size(); }
+	PrimitiveRef getPrimitive(uint32_t object) const { return primitives[object]; }
+	bool isShadowCaster(uint32_t object) const { return shadowCasters[object] != 0; }
+
+	Vec3 getSphereCenter(uint32_t slot) const { return Vec3{ spheres.centerX[slot], spheres.centerY[slot], spheres.centerZ[slot] }; }
+	float getSphereSqRadius(uint32_t slot) const { return spheres.sqradius[slot]; }
+	Vec3 getPlaneNormal(uint32_t slot) const { return Vec3{ planes.normalX[slot], planes.normalY[slot], planes.normalZ[slot] }; }
+	float getPlaneD(uint32_t slot) const { return planes.d[slot]; }
+
+	/// <summary>
+	/// Closest hit over all objects, on equal distances the lower object index
+	/// wins. Shadow rays ignore objects that do not cast shadows.
+	/// </summary>
+	CompiledHit intersect(const Ray& ray, bool shadowRay) const;
+
+	/// <summary>
+	/// Returns true if any shadow caster is hit at a distance of at most maxT.
+	/// </summary>
+	bool occluded(const Ray& ray, float maxT) const;
+
+	/// <summary>
+	/// Tests of a single object, used for the candidates found by the BVH.
+	/// GENERIC objects also return their intersection record.
+	/// </summary>
+	bool intersect(uint32_t object, const Ray& ray, float& t, std::optional<Intersection>& intersection) const;
+	bool hits(uint32_t object, const Ray& ray, float tMax) const;
+
+	/// <summary>
+	/// Builds the full intersection record for a hit found by one of the tests
+	/// above. Spheres and planes compute it from t, GENERIC objects complete
+	/// the record their test returned.
+	/// </summary>
+	std::optional<Intersection> makeIntersection(uint32_t object, const Ray& ray, float t,
+	                                             std::optional<Intersection> intersection) const;
+
+private:
+	bool intersectSphere(uint32_t slot, const Ray& ray, float& t) const;
+	bool intersectPlane(uint32_t slot, const Ray& ray, float& t) const;
+};
@@ -0,0 +1,75 @@
+#include "FilmBuffer.h"
+#include <algorithm>
+#include <cmath>
+
+FilmBuffer::FilmBuffer(uint32_t width, uint32_t height)
+{
+    resize(width, height);
+}
+
+void FilmBuffer::resize(uint32_t width, uint32_t height)
+{
+    this->width = width;
+    this->height = height;
+    clear();
+}
+
+void FilmBuffer::clear()
+{
+    sums.assign(size_t(width) * height, Vec3{ 0.0f, 0.0f, 0.0f });
+    sampleCounts.assign(size_t(width) * height, 0);
+}
+
+void FilmBuffer::addSample(uint32_t x, uint32_t y, const Vec3& color)
+{
+    const size_t index = size_t(y) * width + x;
+    sums[index] = sums[index] + color;
+    ++sampleCounts[index];
+}
+
+void FilmBuffer::addSamples(uint32_t x, uint32_t y, const Vec3& sum, uint32_t count)
+{
+    const size_t index = size_t(y) * width + x;
+    sums[index] = sums[index] + sum;
+    sampleCounts[index] += count;
+}
+
+Vec3 FilmBuffer::getColor(uint32_t x, uint32_t y) const
+{
+    const size_t index = size_t(y) * width + x;
+    if (sampleCounts[index] == 0)
+        return Vec3{ 0.0f, 0.0f, 0.0f };
+    return sums[index] / float(sampleCounts[index]);
+}
+
+Image FilmBuffer::getSampleHeatmap() const
+{
+    Image heatmap(width, height, 4);
+    uint32_t maxCount = 1;
+    for (uint32_t count : sampleCounts)
+        maxCount = std::max(maxCount, count);
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const uint32_t count = std::max(1u, getSampleCount(x, y));
+            const float t = maxCount > 1 ? float(count - 1) / float(maxCount - 1) : 0.0f;
+            heatmap.setNormalizedValue(x, y, 0, std::clamp(2.0f * t - 1.0f, 0.0f, 1.0f));
+            heatmap.setNormalizedValue(x, y, 1, 1.0f - std::abs(2.0f * t - 1.0f));
+            heatmap.setNormalizedValue(x, y, 2, std::clamp(1.0f - 2.0f * t, 0.0f, 1.0f));
+            heatmap.setValue(x, y, 3, 255);
+        }
+    }
+    return heatmap;
+}
+
+double FilmBuffer::getAverageSampleCount() const
+{
+    if (sampleCounts.empty())
+        return 0.0;
+    double sum = 0.0;
+    for (uint32_t count : sampleCounts)
+        sum += count;
+    return sum / double(sampleCounts.size());
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <Vec3.h>
+#include <Image.h>
+
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// High dynamic range film: the sum of all samples of every pixel as floats
+/// together with their count. Nothing is clamped or quantized here, that is
+/// left to the ToneMapper, so a finished render can be exposed again without
+/// tracing a single ray.
+/// </summary>
+class FilmBuffer
+{
+private:
+	uint32_t width;
+	uint32_t height;
+	std::vector<Vec3> sums;
+	std::vector<uint32_t> sampleCounts;
+
+public:
+	FilmBuffer(uint32_t width = 0, uint32_t height = 0);
+
+	/// <summary>
+	/// Changes the size of the film and clears it.
+	/// </summary>
+	void resize(uint32_t width, uint32_t height);
+	void clear();
+
+	uint32_t getWidth() const { return width; }
+	uint32_t getHeight() const { return height; }
+
+	/// <summary>
+	/// Adds a single sample or the sum of count samples to a pixel. Different
+	/// pixels may be written by different threads at the same time.
+	/// </summary>
+	void addSample(uint32_t x, uint32_t y, const Vec3& color);
+	void addSamples(uint32_t x, uint32_t y, const Vec3& sum, uint32_t count);
+
+	/// <summary>
+	/// Mean of all samples of the pixel, black if it has none.
+	/// </summary>
+	Vec3 getColor(uint32_t x, uint32_t y) const;
+	uint32_t getSampleCount(uint32_t x, uint32_t y) const { return sampleCounts[size_t(y) * width + x]; }
+
+	/// <summary>
+	/// Number of samples of every pixel as a heatmap from blue (one sample)
+	/// over green to red (maximum).
+	/// </summary>
+	Image getSampleHeatmap() const;
+	double getAverageSampleCount() const;
+};
@@ -0,0 +1,61 @@
+#include "Instance.h"
+
+Instance::Instance(std::shared_ptr<const IntersectableObject> object, const Mat4& transform)
+	: Instance(object, transform, object->getMaterial())
+{
+}
+
+Instance::Instance(std::shared_ptr<const IntersectableObject> object, const Mat4& transform, const Material& material)
+	: object(object), transform(transform), inverse(Mat4::inverse(transform)),
+	normalTransform(Mat4::transpose(inverse)), material(material)
+{
+}
+
+Material Instance::getMaterial() const
+{
+	return material;
+}
+
+Ray Instance::toObjectSpace(const Ray& ray, float& scale) const
+{
+	const Vec3 origin = inverse * ray.getOrigin();
+	const Vec4 d = inverse * Vec4{ ray.getDirection(), 0.0f };
+	const Vec3 direction{ d.x, d.y, d.z };
+	scale = direction.length();
+	return Ray{ origin, direction / scale };
+}
+
+std::optional<Intersection> Instance::intersect(const Ray& ray) const
+{
+	float scale;
+	const std::optional<Intersection> i = object->intersect(toObjectSpace(ray, scale));
+	if (!i.has_value())
+		return {};
+
+	const Vec4 n = normalTransform * Vec4{ i->getNormal(), 0.0f };
+	return Intersection{ Vec3::normalize(Vec3{ n.x, n.y, n.z }), i->getT() / scale };
+}
+
+bool Instance::hits(const Ray& ray, float tMax) const
+{
+	float scale;
+	const Ray objectRay = toObjectSpace(ray, scale);
+	return object->hits(objectRay, tMax * scale);
+}
+
+std::optional<AABB> Instance::getBounds() const
+{
+	const std::optional<AABB> objectBounds = object->getBounds();
+	if (!objectBounds.has_value())
+		return {};
+
+	AABB box;
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		const Vec3 p{ corner & 1 ? objectBounds->max.x : objectBounds->min.x,
+		              corner & 2 ? objectBounds->max.y : objectBounds->min.y,
+		              corner & 4 ? objectBounds->max.z : objectBounds->min.z };
+		box.extend(transform * p);
+	}
+	return box;
+}
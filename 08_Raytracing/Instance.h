@@ -0,0 +1,47 @@
+#pragma once
+#include <Mat4.h>
+
+#include <memory>
+
+#include "IntersectableObject.h"
+
+/// <summary>
+/// Places a shared object, e.g. a TriangleMesh or an ObjectGroup, in the
+/// scene with an affine transformation. Rays are transformed into the
+/// object space of the shared object and the hits back into world space, so
+/// any number of instances use the memory of a single copy of the geometry.
+/// The instances themselves are the primitives of the scene BVH.
+/// </summary>
+class Instance : public IntersectableObject
+{
+private:
+	std::shared_ptr<const IntersectableObject> object;
+	Mat4 transform;
+	Mat4 inverse;
+	Mat4 normalTransform;	// transposed inverse
+	const Material material;
+
+public:
+	/// <summary>
+	/// The instance uses the material of the object unless another one is given.
+	/// </summary>
+	Instance(std::shared_ptr<const IntersectableObject> object, const Mat4& transform);
+	Instance(std::shared_ptr<const IntersectableObject> object, const Mat4& transform, const Material& material);
+	virtual ~Instance() {}
+
+	Material getMaterial() const override;
+	std::optional<Intersection> intersect(const Ray& ray) const override;
+	bool hits(const Ray& ray, float tMax) const override;
+	std::optional<AABB> getBounds() const override;
+
+	const Mat4& getTransform() const { return transform; }
+	const std::shared_ptr<const IntersectableObject>& getObject() const { return object; }
+
+private:
+	/// <summary>
+	/// Returns the ray in object space with a normalized direction, scale
+	/// receives the factor that converts world space distances along the ray
+	/// into object space distances.
+	/// </summary>
+	Ray toObjectSpace(const Ray& ray, float& scale) const;
+};
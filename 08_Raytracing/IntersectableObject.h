@@ -1,4 +1,5 @@
 #pragma once
+#include "AABB.h"
 #include "Material.h"
 #include "Intersection.h"
 #include "Ray.h"
@@ -11,5 +12,21 @@ public:
 	virtual Material getMaterial() const = 0;
 	virtual std::optional<Intersection> intersect(const Ray& ray) const = 0;
 
+	/// <summary>
+	/// Any-hit query for shadow rays: returns true if intersect would report a
+	/// hit with t <= tMax. Objects should override this with a test that does
+	/// not build an Intersection.
+	/// </summary>
+	virtual bool hits(const Ray& ray, float tMax) const
+	{
+		std::optional<Intersection> i = intersect(ray);
+		return i.has_value() && i->getT() <= tMax;
+	}
+
+	/// <summary>
+	/// Returns a box enclosing the object or nothing for unbounded objects such as planes.
+	/// </summary>
+	virtual std::optional<AABB> getBounds() const { return {}; }
+
 };
 
@@ -1,8 +1,13 @@
 #include "Intersection.h"
 
-Material Intersection::getMaterial() const
+uint32_t Intersection::getMaterialID() const
 {
-    return material;
+    return materialID;
+}
+
+void Intersection::setMaterialID(uint32_t materialID)
+{
+    this->materialID = materialID;
 }
 
 Vec3 Intersection::getNormal() const
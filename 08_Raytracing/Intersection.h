@@ -1,20 +1,30 @@
 #pragma once
-#include "Material.h"
+#include <cstdint>
 #include <Vec3.h>
 
+/// <summary>
+/// Hit data of a ray. The material is only referenced by its index into the
+/// material table of the Scene, objects create intersections without it and
+/// Scene::intersect fills in the index of the closest hit.
+/// </summary>
 class Intersection
 {
 private:
-	Material material;
+	uint32_t materialID;
 	Vec3 normal;
 	float t;
 
 public:
-	Intersection(const Material& material, const Vec3& normal, float t)
-		: material(material), normal(normal), t(t)
+	Intersection(const Vec3& normal, float t)
+		: materialID(0), normal(normal), t(t)
 	{ };
 
-	Material getMaterial() const;
+	Intersection(uint32_t materialID, const Vec3& normal, float t)
+		: materialID(materialID), normal(normal), t(t)
+	{ };
+
+	uint32_t getMaterialID() const;
+	void setMaterialID(uint32_t materialID);
 	Vec3 getNormal() const;
 	float getT() const;
 
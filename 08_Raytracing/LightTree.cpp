@@ -0,0 +1,109 @@
+#include "LightTree.h"
+#include <algorithm>
+#include <cmath>
+
+LightTree::LightTree(const std::vector<Vec3>& positions, const std::vector<float>& powers)
+{
+	std::vector<BuildLight> lights;
+	lights.reserve(positions.size());
+	for (uint32_t i = 0; i < uint32_t(positions.size()); ++i)
+		lights.push_back(BuildLight{ positions[i], std::max(0.0f, powers[i]), i });
+
+	if (!lights.empty())
+	{
+		nodes.reserve(2 * lights.size());
+		build(lights, 0, uint32_t(lights.size()));
+	}
+}
+
+uint32_t LightTree::build(std::vector<BuildLight>& lights, uint32_t first, uint32_t count)
+{
+	AABB bounds;
+	float power = 0.0f;
+	for (uint32_t i = first; i < first + count; ++i)
+	{
+		bounds.extend(lights[i].position);
+		power += lights[i].power;
+	}
+
+	const uint32_t nodeIndex = uint32_t(nodes.size());
+	if (count == 1)
+	{
+		nodes.push_back(LightTreeNode{ bounds, power, lights[first].index, true });
+		return nodeIndex;
+	}
+	nodes.push_back(LightTreeNode{ bounds, power, 0, false });
+
+	// median split along the longest axis keeps the tree balanced
+	const Vec3 extent = bounds.extent();
+	int axis = 0;
+	if (extent.y > extent.e[axis]) axis = 1;
+	if (extent.z > extent.e[axis]) axis = 2;
+
+	const uint32_t half = count / 2;
+	std::nth_element(lights.begin() + first, lights.begin() + first + half, lights.begin() + first + count,
+	                 [axis](const BuildLight& a, const BuildLight& b) { return a.position.e[axis] < b.position.e[axis]; });
+
+	build(lights, first, half);
+	const uint32_t secondChild = build(lights, first + half, count - half);
+	nodes[nodeIndex].offset = secondChild;
+	return nodeIndex;
+}
+
+/// <summary>
+/// Upper estimate of the light a node sends to a shading point: its power
+/// over the squared distance, weighted with the largest cosine between the
+/// normal and any direction into the bounding sphere of the node.
+/// </summary>
+float LightTree::importance(const LightTreeNode& node, const Vec3& position, const Vec3& normal) const
+{
+	const Vec3 toNode = node.bounds.center() - position;
+	const float radius = 0.5f * node.bounds.extent().length();
+	const float sqDistance = toNode.sqlength();
+
+	float cosBound = 1.0f;
+	if (sqDistance > radius * radius)
+	{
+		const float distance = std::sqrt(sqDistance);
+		const float cosTheta = Vec3::dot(toNode, normal) / distance;
+		const float sinCone = radius / distance;
+		const float cosCone = std::sqrt(std::max(0.0f, 1.0f - sinCone * sinCone));
+		if (cosTheta < cosCone)
+		{
+			// cos(theta - cone) for the direction in the cone closest to the normal
+			const float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+			cosBound = cosTheta * cosCone + sinTheta * sinCone;
+		}
+	}
+
+	return node.power * std::max(cosBound, MIN_COSINE) / std::max({ sqDistance, radius * radius, MIN_SQ_DISTANCE });
+}
+
+LightSample LightTree::sample(const Vec3& position, const Vec3& normal, float u) const
+{
+	uint32_t index = 0;
+	float pdf = 1.0f;
+	while (!nodes[index].leaf)
+	{
+		const uint32_t first = index + 1;
+		const uint32_t second = nodes[index].offset;
+		const float w0 = importance(nodes[first], position, normal);
+		const float w1 = importance(nodes[second], position, normal);
+		const float p0 = w0 + w1 > 0.0f ? w0 / (w0 + w1) : 0.5f;
+
+		// reuse u for the next level by stretching the chosen interval back to [0, 1)
+		if (u < p0)
+		{
+			u = std::min(u / p0, 0.99999994f);
+			pdf *= p0;
+			index = first;
+		}
+		else
+		{
+			u = std::min((u - p0) / (1.0f - p0), 0.99999994f);
+			pdf *= 1.0f - p0;
+			index = second;
+		}
+	}
+	return LightSample{ nodes[index].offset, pdf };
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <Vec3.h>
+#include <cstdint>
+#include <vector>
+
+#include "AABB.h"
+
+/// <summary>
+/// Node of the light tree, stored in depth first order like BVHNode: the
+/// first child of an interior node directly follows its parent.
+/// </summary>
+struct LightTreeNode
+{
+	AABB bounds;
+	float power;		// summed power of all lights below the node
+	uint32_t offset;	// leaf: index of the light, interior: index of the second child
+	bool leaf;
+};
+
+/// <summary>
+/// A light picked by LightTree::sample and the probability of picking it.
+/// </summary>
+struct LightSample
+{
+	uint32_t light;
+	float pdf;
+};
+
+/// <summary>
+/// Binary hierarchy over point lights. Every node bounds the positions of its
+/// lights and knows their total power, from which sample estimates how much
+/// the node can contribute to a shading point. A light is picked by walking
+/// down the tree and choosing each child with a probability proportional to
+/// that estimate, so close and bright lights are picked often, yet every
+/// light keeps a nonzero probability and the estimate stays unbiased.
+/// </summary>
+class LightTree
+{
+private:
+	// lights behind the surface still get a small share, the specular term
+	// and shadow rays that miss their own surface can see them
+	static constexpr float MIN_COSINE = 0.05f;
+	static constexpr float MIN_SQ_DISTANCE = 1e-4f;
+
+	struct BuildLight
+	{
+		Vec3 position;
+		float power;
+		uint32_t index;
+	};
+
+	std::vector<LightTreeNode> nodes;
+
+public:
+	LightTree() = default;
+
+	/// <summary>
+	/// Builds the tree over the lights at positions with the given powers,
+	/// the light indices of the samples refer to these arrays.
+	/// </summary>
+	LightTree(const std::vector<Vec3>& positions, const std::vector<float>& powers);
+
+	bool isEmpty() const { return nodes.empty(); }
+	size_t getNodeCount() const { return nodes.size(); }
+
+	/// <summary>
+	/// Picks a light for the shading point at position with the given
+	/// normal, u is a uniform random number in [0, 1).
+	/// </summary>
+	LightSample sample(const Vec3& position, const Vec3& normal, float u) const;
+
+private:
+	uint32_t build(std::vector<BuildLight>& lights, uint32_t first, uint32_t count);
+	float importance(const LightTreeNode& node, const Vec3& position, const Vec3& normal) const;
+};
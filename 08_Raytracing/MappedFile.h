@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Read-only view of a whole file mapped into memory. Pages are only read
+/// from disk when they are touched, and a file that is still in the page
+/// cache is available without any copy. The mapping is released by the
+/// destructor, pointers into it must not outlive the object.
+/// </summary>
+class MappedFile
+{
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool isOpen() const { return data != nullptr; }
+	const uint8_t* getData() const { return data; }
+	size_t getSize() const { return size; }
+
+private:
+	void close();
+};
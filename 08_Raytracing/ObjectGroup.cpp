@@ -0,0 +1,76 @@
+#include "ObjectGroup.h"
+#include <limits>
+
+ObjectGroup::ObjectGroup(const std::vector<std::shared_ptr<const IntersectableObject>>& objects, const Material& material)
+	: objects(objects), material(material)
+{
+	std::vector<AABB> objectBounds;
+	for (uint32_t i = 0; i < uint32_t(objects.size()); ++i)
+	{
+		const std::optional<AABB> box = objects[i]->getBounds();
+		if (box.has_value())
+		{
+			boundedObjects.push_back(i);
+			objectBounds.push_back(box.value());
+			bounds.extend(box.value());
+		}
+		else
+		{
+			unboundedObjects.push_back(i);
+		}
+	}
+
+	if (!objectBounds.empty())
+		bvh = BVH(objectBounds);
+}
+
+Material ObjectGroup::getMaterial() const
+{
+	return material;
+}
+
+std::optional<Intersection> ObjectGroup::intersect(const Ray& ray) const
+{
+	std::optional<Intersection> closest;
+	auto test = [&](uint32_t index, float& tMax)
+	{
+		std::optional<Intersection> i = objects[index]->intersect(ray);
+		if (i.has_value() && i->getT() <= tMax)
+		{
+			tMax = i->getT();
+			closest = i;
+		}
+		return false;
+	};
+
+	for (uint32_t index : unboundedObjects)
+	{
+		float tMax = closest.has_value() ? closest->getT() : std::numeric_limits<float>::max();
+		test(index, tMax);
+	}
+	bvh.traverse(ray, closest.has_value() ? closest->getT() : std::numeric_limits<float>::max(),
+		[&](uint32_t primitive, float& tMax) { return test(boundedObjects[primitive], tMax); });
+	return closest;
+}
+
+bool ObjectGroup::hits(const Ray& ray, float tMax) const
+{
+	for (uint32_t index : unboundedObjects)
+		if (objects[index]->hits(ray, tMax))
+			return true;
+
+	bool hit = false;
+	bvh.traverse(ray, tMax, [&](uint32_t primitive, float& maxT)
+	{
+		hit = objects[boundedObjects[primitive]]->hits(ray, maxT);
+		return hit;
+	});
+	return hit;
+}
+
+std::optional<AABB> ObjectGroup::getBounds() const
+{
+	if (!unboundedObjects.empty() || boundedObjects.empty())
+		return {};
+	return bounds;
+}
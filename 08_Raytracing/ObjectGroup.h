@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BVH.h"
+#include "IntersectableObject.h"
+
+/// <summary>
+/// A set of objects that acts as a single object, e.g. a cluster of spheres
+/// that is placed many times with Instance. The group has its own BVH over
+/// the bounded members, so instancing a group does not copy any geometry.
+/// The whole group is rendered with one material, the materials of the
+/// members are ignored.
+/// </summary>
+class ObjectGroup : public IntersectableObject
+{
+private:
+	std::vector<std::shared_ptr<const IntersectableObject>> objects;
+	std::vector<uint32_t> boundedObjects;	// maps BVH primitives to objects
+	std::vector<uint32_t> unboundedObjects;
+	AABB bounds;
+	BVH bvh;
+	const Material material;
+
+public:
+	ObjectGroup(const std::vector<std::shared_ptr<const IntersectableObject>>& objects, const Material& material);
+	virtual ~ObjectGroup() {}
+
+	Material getMaterial() const override;
+	std::optional<Intersection> intersect(const Ray& ray) const override;
+	bool hits(const Ray& ray, float tMax) const override;
+	std::optional<AABB> getBounds() const override;
+
+	size_t getObjectCount() const { return objects.size(); }
+};
@@ -0,0 +1,448 @@
+#include "PacketKernels.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+  #define PACKET_X86 1
+  #include <immintrin.h>
+  #if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define TARGET_AVX2
+  #else
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+  #endif
+#else
+  #define PACKET_X86 0
+#endif
+
+namespace {
+
+// factor AABB::intersect applies to the far distance of every slab
+constexpr float FAR_SCALE = 1.0f + 2.0f * std::numeric_limits<float>::epsilon();
+
+// ---- scalar fallback, one lane at a time ----
+
+bool sphereDistance(const RayPacket& p, uint32_t i, const Vec3& c, float sqradius, float& t)
+{
+	const float lx = c.x - p.ox[i];
+	const float ly = c.y - p.oy[i];
+	const float lz = c.z - p.oz[i];
+	const float tCenter = lx * p.dx[i] + ly * p.dy[i] + lz * p.dz[i];
+	if (tCenter < 0)
+		return false;
+	const float dSq = (lx * lx + ly * ly + lz * lz) - tCenter * tCenter;
+	if (dSq > sqradius)
+		return false;
+	const float dist = std::sqrt(sqradius - dSq);
+	t = tCenter - dist;
+	if (t < 0)
+		t = tCenter + dist;
+	return true;
+}
+
+bool planeDistance(const RayPacket& p, uint32_t i, const Vec3& n, float d, float& t)
+{
+	const float denom = p.dx[i] * n.x + p.dy[i] * n.y + p.dz[i] * n.z;
+	if (denom == 0.0f)
+		return false;
+	t = -((p.ox[i] * n.x + p.oy[i] * n.y + p.oz[i] * n.z) + d) / denom;
+	return true;
+}
+
+void updateClosest(PacketHit& hit, uint32_t i, float t, int32_t object)
+{
+	if (hit.object[i] < 0 || t < hit.t[i] || (t == hit.t[i] && object < hit.object[i]))
+	{
+		hit.t[i] = t;
+		hit.object[i] = object;
+	}
+}
+
+uint32_t intersectBoxScalar(const RayPacket& p, uint32_t mask, const AABB& box, const float* tMax)
+{
+	uint32_t result = 0;
+	for (uint32_t i = 0; i < PACKET_SIZE; ++i)
+	{
+		float tNear;
+		const Vec3 origin{ p.ox[i], p.oy[i], p.oz[i] };
+		const Vec3 invDir{ p.invDx[i], p.invDy[i], p.invDz[i] };
+		if ((mask & (1u << i)) && box.intersect(origin, invDir, tMax[i], tNear))
+			result |= 1u << i;
+	}
+	return result;
+}
+
+void intersectSphereScalar(const RayPacket& p, uint32_t mask, const Vec3& center, float sqradius, int32_t object, PacketHit& hit)
+{
+	for (uint32_t i = 0; i < PACKET_SIZE; ++i)
+	{
+		float t;
+		if ((mask & (1u << i)) && sphereDistance(p, i, center, sqradius, t))
+			updateClosest(hit, i, t, object);
+	}
+}
+
+void intersectPlaneScalar(const RayPacket& p, uint32_t mask, const Vec3& normal, float d, int32_t object, PacketHit& hit)
+{
+	for (uint32_t i = 0; i < PACKET_SIZE; ++i)
+	{
+		float t;
+		if ((mask & (1u << i)) && planeDistance(p, i, normal, d, t) && !(t < 0))
+			updateClosest(hit, i, t, object);
+	}
+}
+
+uint32_t hitsSphereScalar(const RayPacket& p, uint32_t mask, const Vec3& center, float sqradius, const float* tMax)
+{
+	uint32_t result = 0;
+	for (uint32_t i = 0; i < PACKET_SIZE; ++i)
+	{
+		float t;
+		if ((mask & (1u << i)) && sphereDistance(p, i, center, sqradius, t) && t <= tMax[i])
+			result |= 1u << i;
+	}
+	return result;
+}
+
+uint32_t hitsPlaneScalar(const RayPacket& p, uint32_t mask, const Vec3& normal, float d, const float* tMax)
+{
+	uint32_t result = 0;
+	for (uint32_t i = 0; i < PACKET_SIZE; ++i)
+	{
+		float t;
+		if ((mask & (1u << i)) && planeDistance(p, i, normal, d, t) && t >= 0 && t <= tMax[i])
+			result |= 1u << i;
+	}
+	return result;
+}
+
+#if PACKET_X86
+
+// ---- SSE, two groups of four lanes ----
+
+// returns the lanes of the group that hit the sphere, t receives their distance
+inline __m128 sphereDistanceSSE(const RayPacket& p, uint32_t g, const Vec3& c, float sqradius, __m128& t)
+{
+	const __m128 lx = _mm_sub_ps(_mm_set1_ps(c.x), _mm_load_ps(p.ox + g));
+	const __m128 ly = _mm_sub_ps(_mm_set1_ps(c.y), _mm_load_ps(p.oy + g));
+	const __m128 lz = _mm_sub_ps(_mm_set1_ps(c.z), _mm_load_ps(p.oz + g));
+	const __m128 tCenter = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, _mm_load_ps(p.dx + g)),
+		_mm_mul_ps(ly, _mm_load_ps(p.dy + g))), _mm_mul_ps(lz, _mm_load_ps(p.dz + g)));
+	const __m128 lSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz));
+	const __m128 dSq = _mm_sub_ps(lSq, _mm_mul_ps(tCenter, tCenter));
+	const __m128 r2 = _mm_set1_ps(sqradius);
+	const __m128 miss = _mm_or_ps(_mm_cmplt_ps(tCenter, _mm_setzero_ps()), _mm_cmpgt_ps(dSq, r2));
+	const __m128 dist = _mm_sqrt_ps(_mm_sub_ps(r2, dSq));
+	const __m128 tNear = _mm_sub_ps(tCenter, dist);
+	const __m128 tFar = _mm_add_ps(tCenter, dist);
+	const __m128 inside = _mm_cmplt_ps(tNear, _mm_setzero_ps());
+	t = _mm_or_ps(_mm_and_ps(inside, tFar), _mm_andnot_ps(inside, tNear));
+	return _mm_andnot_ps(miss, _mm_castsi128_ps(_mm_set1_epi32(-1)));
+}
+
+inline __m128 planeDistanceSSE(const RayPacket& p, uint32_t g, const Vec3& n, float d, __m128& t)
+{
+	const __m128 nx = _mm_set1_ps(n.x);
+	const __m128 ny = _mm_set1_ps(n.y);
+	const __m128 nz = _mm_set1_ps(n.z);
+	const __m128 denom = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(p.dx + g), nx),
+		_mm_mul_ps(_mm_load_ps(p.dy + g), ny)), _mm_mul_ps(_mm_load_ps(p.dz + g), nz));
+	const __m128 dotO = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(p.ox + g), nx),
+		_mm_mul_ps(_mm_load_ps(p.oy + g), ny)), _mm_mul_ps(_mm_load_ps(p.oz + g), nz));
+	const __m128 negated = _mm_xor_ps(_mm_add_ps(dotO, _mm_set1_ps(d)), _mm_set1_ps(-0.0f));
+	t = _mm_div_ps(negated, denom);
+	return _mm_cmpneq_ps(denom, _mm_setzero_ps());
+}
+
+inline uint32_t laneMask(uint32_t mask, uint32_t g)
+{
+	return (mask >> g) & 0xF;
+}
+
+inline void updateClosestSSE(PacketHit& hit, uint32_t g, __m128 valid, __m128 t, int32_t object)
+{
+	const __m128 bestT = _mm_load_ps(hit.t + g);
+	const __m128i bestObject = _mm_load_si128(reinterpret_cast<const __m128i*>(hit.object + g));
+	const __m128i objectV = _mm_set1_epi32(object);
+	const __m128 noHit = _mm_castsi128_ps(_mm_cmplt_epi32(bestObject, _mm_setzero_si128()));
+	const __m128 closer = _mm_cmplt_ps(t, bestT);
+	const __m128 tie = _mm_and_ps(_mm_cmpeq_ps(t, bestT), _mm_castsi128_ps(_mm_cmplt_epi32(objectV, bestObject)));
+	const __m128 update = _mm_and_ps(valid, _mm_or_ps(noHit, _mm_or_ps(closer, tie)));
+	_mm_store_ps(hit.t + g, _mm_or_ps(_mm_and_ps(update, t), _mm_andnot_ps(update, bestT)));
+	const __m128i updateI = _mm_castps_si128(update);
+	_mm_store_si128(reinterpret_cast<__m128i*>(hit.object + g),
+		_mm_or_si128(_mm_and_si128(updateI, objectV), _mm_andnot_si128(updateI, bestObject)));
+}
+
+inline __m128 activeLanesSSE(uint32_t mask, uint32_t g)
+{
+	const uint32_t m = laneMask(mask, g);
+	const __m128i bits = _mm_set_epi32(8, 4, 2, 1);
+	const __m128i set = _mm_and_si128(_mm_set1_epi32(int32_t(m)), bits);
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(set, bits));
+}
+
+uint32_t intersectBoxSSE(const RayPacket& p, uint32_t mask, const AABB& box, const float* tMax)
+{
+	uint32_t result = 0;
+	for (uint32_t g = 0; g < PACKET_SIZE; g += 4)
+	{
+		if (laneMask(mask, g) == 0)
+			continue;
+		__m128 t0 = _mm_setzero_ps();
+		__m128 t1 = _mm_loadu_ps(tMax + g);
+		const float* origins[3] = { p.ox + g, p.oy + g, p.oz + g };
+		const float* invDirs[3] = { p.invDx + g, p.invDy + g, p.invDz + g };
+		for (int a = 0; a < 3; ++a)
+		{
+			const __m128 o = _mm_load_ps(origins[a]);
+			const __m128 inv = _mm_load_ps(invDirs[a]);
+			const __m128 tA = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.e[a]), o), inv);
+			const __m128 tB = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.e[a]), o), inv);
+			const __m128 swap = _mm_cmpgt_ps(tA, tB);
+			const __m128 lo = _mm_or_ps(_mm_and_ps(swap, tB), _mm_andnot_ps(swap, tA));
+			const __m128 hi = _mm_mul_ps(_mm_or_ps(_mm_and_ps(swap, tA), _mm_andnot_ps(swap, tB)), _mm_set1_ps(FAR_SCALE));
+			const __m128 takeLo = _mm_cmpgt_ps(lo, t0);
+			const __m128 takeHi = _mm_cmplt_ps(hi, t1);
+			t0 = _mm_or_ps(_mm_and_ps(takeLo, lo), _mm_andnot_ps(takeLo, t0));
+			t1 = _mm_or_ps(_mm_and_ps(takeHi, hi), _mm_andnot_ps(takeHi, t1));
+		}
+		const uint32_t miss = uint32_t(_mm_movemask_ps(_mm_cmpgt_ps(t0, t1)));
+		result |= ((~miss & 0xF) & laneMask(mask, g)) << g;
+	}
+	return result;
+}
+
+void intersectSphereSSE(const RayPacket& p, uint32_t mask, const Vec3& center, float sqradius, int32_t object, PacketHit& hit)
+{
+	for (uint32_t g = 0; g < PACKET_SIZE; g += 4)
+	{
+		if (laneMask(mask, g) == 0)
+			continue;
+		__m128 t;
+		const __m128 valid = _mm_and_ps(sphereDistanceSSE(p, g, center, sqradius, t), activeLanesSSE(mask, g));
+		updateClosestSSE(hit, g, valid, t, object);
+	}
+}
+
+void intersectPlaneSSE(const RayPacket& p, uint32_t mask, const Vec3& normal, float d, int32_t object, PacketHit& hit)
+{
+	for (uint32_t g = 0; g < PACKET_SIZE; g += 4)
+	{
+		if (laneMask(mask, g) == 0)
+			continue;
+		__m128 t;
+		__m128 valid = _mm_and_ps(planeDistanceSSE(p, g, normal, d, t), activeLanesSSE(mask, g));
+		valid = _mm_andnot_ps(_mm_cmplt_ps(t, _mm_setzero_ps()), valid);
+		updateClosestSSE(hit, g, valid, t, object);
+	}
+}
+
+uint32_t hitsSphereSSE(const RayPacket& p, uint32_t mask, const Vec3& center, float sqradius, const float* tMax)
+{
+	uint32_t result = 0;
+	for (uint32_t g = 0; g < PACKET_SIZE; g += 4)
+	{
+		if (laneMask(mask, g) == 0)
+			continue;
+		__m128 t;
+		const __m128 valid = sphereDistanceSSE(p, g, center, sqradius, t);
+		const __m128 hits = _mm_and_ps(valid, _mm_cmple_ps(t, _mm_loadu_ps(tMax + g)));
+		result |= (uint32_t(_mm_movemask_ps(hits)) & laneMask(mask, g)) << g;
+	}
+	return result;
+}
+
+uint32_t hitsPlaneSSE(const RayPacket& p, uint32_t mask, const Vec3& normal, float d, const float* tMax)
+{
+	uint32_t result = 0;
+	for (uint32_t g = 0; g < PACKET_SIZE; g += 4)
+	{
+		if (laneMask(mask, g) == 0)
+			continue;
+		__m128 t;
+		const __m128 valid = planeDistanceSSE(p, g, normal, d, t);
+		const __m128 inRange = _mm_and_ps(_mm_cmpge_ps(t, _mm_setzero_ps()), _mm_cmple_ps(t, _mm_loadu_ps(tMax + g)));
+		result |= (uint32_t(_mm_movemask_ps(_mm_and_ps(valid, inRange))) & laneMask(mask, g)) << g;
+	}
+	return result;
+}
+
+// ---- AVX2, all eight lanes at once ----
+
+TARGET_AVX2 inline __m256 sphereDistanceAVX2(const RayPacket& p, const Vec3& c, float sqradius, __m256& t)
+{
+	const __m256 lx = _mm256_sub_ps(_mm256_set1_ps(c.x), _mm256_load_ps(p.ox));
+	const __m256 ly = _mm256_sub_ps(_mm256_set1_ps(c.y), _mm256_load_ps(p.oy));
+	const __m256 lz = _mm256_sub_ps(_mm256_set1_ps(c.z), _mm256_load_ps(p.oz));
+	const __m256 tCenter = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, _mm256_load_ps(p.dx)),
+		_mm256_mul_ps(ly, _mm256_load_ps(p.dy))), _mm256_mul_ps(lz, _mm256_load_ps(p.dz)));
+	const __m256 lSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz));
+	const __m256 dSq = _mm256_sub_ps(lSq, _mm256_mul_ps(tCenter, tCenter));
+	const __m256 r2 = _mm256_set1_ps(sqradius);
+	const __m256 miss = _mm256_or_ps(_mm256_cmp_ps(tCenter, _mm256_setzero_ps(), _CMP_LT_OQ),
+		_mm256_cmp_ps(dSq, r2, _CMP_GT_OQ));
+	const __m256 dist = _mm256_sqrt_ps(_mm256_sub_ps(r2, dSq));
+	const __m256 tNear = _mm256_sub_ps(tCenter, dist);
+	const __m256 tFar = _mm256_add_ps(tCenter, dist);
+	t = _mm256_blendv_ps(tNear, tFar, _mm256_cmp_ps(tNear, _mm256_setzero_ps(), _CMP_LT_OQ));
+	return _mm256_andnot_ps(miss, _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+}
+
+TARGET_AVX2 inline __m256 planeDistanceAVX2(const RayPacket& p, const Vec3& n, float d, __m256& t)
+{
+	const __m256 nx = _mm256_set1_ps(n.x);
+	const __m256 ny = _mm256_set1_ps(n.y);
+	const __m256 nz = _mm256_set1_ps(n.z);
+	const __m256 denom = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(p.dx), nx),
+		_mm256_mul_ps(_mm256_load_ps(p.dy), ny)), _mm256_mul_ps(_mm256_load_ps(p.dz), nz));
+	const __m256 dotO = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(p.ox), nx),
+		_mm256_mul_ps(_mm256_load_ps(p.oy), ny)), _mm256_mul_ps(_mm256_load_ps(p.oz), nz));
+	const __m256 negated = _mm256_xor_ps(_mm256_add_ps(dotO, _mm256_set1_ps(d)), _mm256_set1_ps(-0.0f));
+	t = _mm256_div_ps(negated, denom);
+	return _mm256_cmp_ps(denom, _mm256_setzero_ps(), _CMP_NEQ_UQ);
+}
+
+TARGET_AVX2 inline __m256 activeLanesAVX2(uint32_t mask)
+{
+	const __m256i bits = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+	const __m256i set = _mm256_and_si256(_mm256_set1_epi32(int32_t(mask)), bits);
+	return _mm256_castsi256_ps(_mm256_cmpeq_epi32(set, bits));
+}
+
+TARGET_AVX2 inline void updateClosestAVX2(PacketHit& hit, __m256 valid, __m256 t, int32_t object)
+{
+	const __m256 bestT = _mm256_load_ps(hit.t);
+	const __m256i bestObject = _mm256_load_si256(reinterpret_cast<const __m256i*>(hit.object));
+	const __m256i objectV = _mm256_set1_epi32(object);
+	const __m256 noHit = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_setzero_si256(), bestObject));
+	const __m256 closer = _mm256_cmp_ps(t, bestT, _CMP_LT_OQ);
+	const __m256 tie = _mm256_and_ps(_mm256_cmp_ps(t, bestT, _CMP_EQ_OQ),
+		_mm256_castsi256_ps(_mm256_cmpgt_epi32(bestObject, objectV)));
+	const __m256 update = _mm256_and_ps(valid, _mm256_or_ps(noHit, _mm256_or_ps(closer, tie)));
+	_mm256_store_ps(hit.t, _mm256_blendv_ps(bestT, t, update));
+	_mm256_store_si256(reinterpret_cast<__m256i*>(hit.object),
+		_mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestObject), _mm256_castsi256_ps(objectV), update)));
+}
+
+TARGET_AVX2 uint32_t intersectBoxAVX2(const RayPacket& p, uint32_t mask, const AABB& box, const float* tMax)
+{
+	__m256 t0 = _mm256_setzero_ps();
+	__m256 t1 = _mm256_loadu_ps(tMax);
+	const float* origins[3] = { p.ox, p.oy, p.oz };
+	const float* invDirs[3] = { p.invDx, p.invDy, p.invDz };
+	for (int a = 0; a < 3; ++a)
+	{
+		const __m256 o = _mm256_load_ps(origins[a]);
+		const __m256 inv = _mm256_load_ps(invDirs[a]);
+		const __m256 tA = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(box.min.e[a]), o), inv);
+		const __m256 tB = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(box.max.e[a]), o), inv);
+		const __m256 swap = _mm256_cmp_ps(tA, tB, _CMP_GT_OQ);
+		const __m256 lo = _mm256_blendv_ps(tA, tB, swap);
+		const __m256 hi = _mm256_mul_ps(_mm256_blendv_ps(tB, tA, swap), _mm256_set1_ps(FAR_SCALE));
+		t0 = _mm256_blendv_ps(t0, lo, _mm256_cmp_ps(lo, t0, _CMP_GT_OQ));
+		t1 = _mm256_blendv_ps(t1, hi, _mm256_cmp_ps(hi, t1, _CMP_LT_OQ));
+	}
+	const uint32_t miss = uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_GT_OQ)));
+	return ~miss & mask;
+}
+
+TARGET_AVX2 void intersectSphereAVX2(const RayPacket& p, uint32_t mask, const Vec3& center, float sqradius, int32_t object, PacketHit& hit)
+{
+	__m256 t;
+	const __m256 valid = _mm256_and_ps(sphereDistanceAVX2(p, center, sqradius, t), activeLanesAVX2(mask));
+	updateClosestAVX2(hit, valid, t, object);
+}
+
+TARGET_AVX2 void intersectPlaneAVX2(const RayPacket& p, uint32_t mask, const Vec3& normal, float d, int32_t object, PacketHit& hit)
+{
+	__m256 t;
+	__m256 valid = _mm256_and_ps(planeDistanceAVX2(p, normal, d, t), activeLanesAVX2(mask));
+	valid = _mm256_andnot_ps(_mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_LT_OQ), valid);
+	updateClosestAVX2(hit, valid, t, object);
+}
+
+TARGET_AVX2 uint32_t hitsSphereAVX2(const RayPacket& p, uint32_t mask, const Vec3& center, float sqradius, const float* tMax)
+{
+	__m256 t;
+	const __m256 valid = sphereDistanceAVX2(p, center, sqradius, t);
+	const __m256 hits = _mm256_and_ps(valid, _mm256_cmp_ps(t, _mm256_loadu_ps(tMax), _CMP_LE_OQ));
+	return uint32_t(_mm256_movemask_ps(hits)) & mask;
+}
+
+TARGET_AVX2 uint32_t hitsPlaneAVX2(const RayPacket& p, uint32_t mask, const Vec3& normal, float d, const float* tMax)
+{
+	__m256 t;
+	const __m256 valid = planeDistanceAVX2(p, normal, d, t);
+	const __m256 inRange = _mm256_and_ps(_mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GE_OQ),
+		_mm256_cmp_ps(t, _mm256_loadu_ps(tMax), _CMP_LE_OQ));
+	return uint32_t(_mm256_movemask_ps(_mm256_and_ps(valid, inRange))) & mask;
+}
+
+#endif
+
+const PacketKernels scalarKernels{ intersectBoxScalar, intersectSphereScalar, intersectPlaneScalar, hitsSphereScalar, hitsPlaneScalar };
+#if PACKET_X86
+const PacketKernels sseKernels{ intersectBoxSSE, intersectSphereSSE, intersectPlaneSSE, hitsSphereSSE, hitsPlaneSSE };
+const PacketKernels avx2Kernels{ intersectBoxAVX2, intersectSphereAVX2, intersectPlaneAVX2, hitsSphereAVX2, hitsPlaneAVX2 };
+#endif
+
+}
+
+SIMDLevel detectSIMDLevel()
+{
+#if PACKET_X86
+  #if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7)
+	{
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		__cpuidex(info, 7, 0);
+		const bool avx2 = (info[1] & (1 << 5)) != 0;
+		// the OS also has to save the upper halves of the ymm registers
+		if (osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6)
+			return SIMDLevel::AVX2;
+	}
+	return SIMDLevel::SSE;
+  #else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SIMDLevel::AVX2;
+	return SIMDLevel::SSE;
+  #endif
+#else
+	return SIMDLevel::SCALAR;
+#endif
+}
+
+std::string toString(SIMDLevel level)
+{
+	switch (level) {
+		case SIMDLevel::AVX2: return "AVX2";
+		case SIMDLevel::SSE: return "SSE";
+		default: return "scalar";
+	}
+}
+
+const PacketKernels& getPacketKernels(SIMDLevel level)
+{
+	static const SIMDLevel supported = detectSIMDLevel();
+	if (int(level) > int(supported))
+		level = supported;
+#if PACKET_X86
+	switch (level) {
+		case SIMDLevel::AVX2: return avx2Kernels;
+		case SIMDLevel::SSE: return sseKernels;
+		default: break;
+	}
+#endif
+	return scalarKernels;
+}
+
+const PacketKernels& getPacketKernels()
+{
+	static const PacketKernels& kernels = getPacketKernels(detectSIMDLevel());
+	return kernels;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "AABB.h"
+#include "RayPacket.h"
+
+enum class SIMDLevel {
+	SCALAR, SSE, AVX2
+};
+
+/// <summary>
+/// Intersection kernels that test all lanes of a packet against a single
+/// primitive. The arithmetic follows the scalar code in Sphere and Plane
+/// operation by operation, so every lane computes the same distance as the
+/// scalar path would. All kernels only update lanes that are set in mask.
+/// </summary>
+struct PacketKernels
+{
+	/// returns the lanes whose segment [0, tMax] overlaps the box
+	uint32_t (*intersectBox)(const RayPacket& packet, uint32_t mask, const AABB& box, const float* tMax);
+	/// closest hit update, on equal distances the lower object index wins
+	void (*intersectSphere)(const RayPacket& packet, uint32_t mask, const Vec3& center, float sqradius, int32_t object, PacketHit& hit);
+	void (*intersectPlane)(const RayPacket& packet, uint32_t mask, const Vec3& normal, float d, int32_t object, PacketHit& hit);
+	/// any hit, returns the lanes with a hit at a distance of at most tMax
+	uint32_t (*hitsSphere)(const RayPacket& packet, uint32_t mask, const Vec3& center, float sqradius, const float* tMax);
+	uint32_t (*hitsPlane)(const RayPacket& packet, uint32_t mask, const Vec3& normal, float d, const float* tMax);
+};
+
+/// <summary>
+/// Highest instruction set supported by the CPU we are running on.
+/// </summary>
+SIMDLevel detectSIMDLevel();
+std::string toString(SIMDLevel level);
+
+/// <summary>
+/// Kernels for the given level, levels that are not compiled in or not
+/// supported by the CPU fall back to the next lower one.
+/// </summary>
+const PacketKernels& getPacketKernels(SIMDLevel level);
+const PacketKernels& getPacketKernels();
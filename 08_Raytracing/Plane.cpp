@@ -15,5 +15,15 @@ std::optional<Intersection> Plane::intersect(const Ray& ray) const
     if (t < 0)
         return {};
 
-    return Intersection{ material, normal, t };
+    return Intersection{ normal, t };
+}
+
+bool Plane::hits(const Ray& ray, float tMax) const
+{
+    float denom = Vec3::dot(ray.getDirection(), normal);
+    if (denom == 0.0)
+        return false;
+
+    float t = -(Vec3::dot(ray.getOrigin(), normal) + d) / denom;
+    return t >= 0 && t <= tMax;
 }
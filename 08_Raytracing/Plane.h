@@ -16,5 +16,9 @@ public:
     
 	Material getMaterial() const override;
 	std::optional<Intersection> intersect(const Ray& ray) const override;
+	bool hits(const Ray& ray, float tMax) const override;
+
+	Vec3 getNormal() const { return normal; }
+	float getD() const { return d; }
 };
 
@@ -13,6 +13,8 @@ public:
 	{ }
 
   virtual ~PointLight(){}
+
+	Vec3 getPosition() const { return position; }
   
 	//Returns normalized direction from position to this PointLight
 	virtual Vec3 getDirection(const Vec3& position) const override;
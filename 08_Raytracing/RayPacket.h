@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#include "Intersection.h"
+#include "Ray.h"
+
+constexpr uint32_t PACKET_SIZE = 8;
+constexpr uint32_t PACKET_FULL_MASK = (1u << PACKET_SIZE) - 1;
+
+/// <summary>
+/// Eight rays in structure of arrays layout so that the SIMD kernels can load
+/// one component of all rays with a single instruction. Bit i of mask marks
+/// lane i as active.
+/// </summary>
+struct RayPacket
+{
+	alignas(32) float ox[PACKET_SIZE];
+	alignas(32) float oy[PACKET_SIZE];
+	alignas(32) float oz[PACKET_SIZE];
+	alignas(32) float dx[PACKET_SIZE];
+	alignas(32) float dy[PACKET_SIZE];
+	alignas(32) float dz[PACKET_SIZE];
+	alignas(32) float invDx[PACKET_SIZE];
+	alignas(32) float invDy[PACKET_SIZE];
+	alignas(32) float invDz[PACKET_SIZE];
+	uint32_t mask = 0;
+
+	void set(uint32_t lane, const Ray& ray)
+	{
+		const Vec3 o = ray.getOrigin();
+		const Vec3 d = ray.getDirection();
+		ox[lane] = o.x; oy[lane] = o.y; oz[lane] = o.z;
+		dx[lane] = d.x; dy[lane] = d.y; dz[lane] = d.z;
+		invDx[lane] = 1.0f / d.x; invDy[lane] = 1.0f / d.y; invDz[lane] = 1.0f / d.z;
+		mask |= 1u << lane;
+	}
+
+	/// <summary>
+	/// Fills inactive lanes with a copy of an active one, the kernels always
+	/// evaluate all lanes and the results of these lanes are masked out.
+	/// </summary>
+	void fillInactive()
+	{
+		if (mask == 0 || mask == PACKET_FULL_MASK)
+			return;
+		uint32_t first = 0;
+		while (!(mask & (1u << first)))
+			++first;
+		for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane)
+		{
+			if (mask & (1u << lane))
+				continue;
+			ox[lane] = ox[first]; oy[lane] = oy[first]; oz[lane] = oz[first];
+			dx[lane] = dx[first]; dy[lane] = dy[first]; dz[lane] = dz[first];
+			invDx[lane] = invDx[first]; invDy[lane] = invDy[first]; invDz[lane] = invDz[first];
+		}
+	}
+
+	Ray get(uint32_t lane) const
+	{
+		return Ray{ Vec3{ ox[lane], oy[lane], oz[lane] }, Vec3{ dx[lane], dy[lane], dz[lane] } };
+	}
+};
+
+/// <summary>
+/// Closest hit per lane, object is -1 for lanes that did not hit anything.
+/// intersection is only set by objects without a SIMD kernel, it keeps the
+/// record of their hit so that it is not computed again for shading.
+/// </summary>
+struct PacketHit
+{
+	alignas(32) float t[PACKET_SIZE];
+	alignas(32) int32_t object[PACKET_SIZE];
+	std::optional<Intersection> intersection[PACKET_SIZE];
+
+	PacketHit()
+	{
+		for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane)
+		{
+			t[lane] = std::numeric_limits<float>::max();
+			object[lane] = -1;
+		}
+	}
+};
@@ -1,6 +1,37 @@
 #define _USE_MATH_DEFINES
 #include "Raytracer.h"
+#include "SampleRandom.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <thread>
+
+namespace {
+
+/// <summary>
+/// Van der Corput radical inverse of i, the Halton sequence in bases 2 and 3
+/// spreads any number of samples evenly over the pixel.
+/// </summary>
+float radicalInverse(uint32_t i, uint32_t base)
+{
+    const float invBase = 1.0f / float(base);
+    float factor = invBase;
+    float result = 0.0f;
+    while (i > 0)
+    {
+        result += factor * float(i % base);
+        i /= base;
+        factor *= invBase;
+    }
+    return result;
+}
+
+float luminance(const Vec3& color)
+{
+    return 0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b;
+}
+
+}
 
 void Raytracer::setCamera(const Camera& camera)
 {
@@ -10,46 +41,407 @@ void Raytracer::setCamera(const Camera& camera)
 void Raytracer::setScene(const Scene& scene)
 {
     this->scene = scene;
+    this->scene.buildAccelerationStructure();
+}
+
+const Scene& Raytracer::getScene() const
+{
+    return scene;
+}
+
+void Raytracer::setThreadCount(uint32_t threadCount)
+{
+    this->threadCount = threadCount;
+}
+
+uint32_t Raytracer::getThreadCount() const
+{
+#ifdef __EMSCRIPTEN__
+    // the web build is compiled without pthread support
+    return 1;
+#else
+    if (threadCount > 0)
+        return threadCount;
+    return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+void Raytracer::setTileSize(uint32_t tileSize)
+{
+    this->tileSize = std::max(1u, tileSize);
+}
+
+uint32_t Raytracer::getTileSize() const
+{
+    return tileSize;
+}
+
+const std::vector<TileStats>& Raytracer::getTileStats() const
+{
+    return tileStats;
+}
+
+void Raytracer::setPacketTracing(bool packetTracing)
+{
+    this->packetTracing = packetTracing;
+}
+
+bool Raytracer::getPacketTracing() const
+{
+    return packetTracing;
+}
+
+void Raytracer::setJitter(bool jitter, uint32_t seed)
+{
+    this->jitter = jitter;
+    this->seed = seed;
+}
+
+bool Raytracer::getJitter() const
+{
+    return jitter;
+}
+
+void Raytracer::setSIMDLevel(SIMDLevel level)
+{
+    scene.setSIMDLevel(level);
 }
 
 void Raytracer::render(Image& img)
 {
-    RaySetup rs = computeRaySetup(img);
+    render(img.width, img.height);
+    toneMapper.apply(film, img);
+}
+
+void Raytracer::render(uint32_t width, uint32_t height)
+{
+    RaySetup rs = computeRaySetup(width, height);
+    tileStats.assign(TileScheduler::getTileCount(width, height, tileSize), TileStats{});
+    film.resize(width, height);
+
+    if (adaptiveSampling.enabled)
+    {
+        renderAdaptive(rs);
+        return;
+    }
+
+    renderTiles(width, height, [&](const Tile& tile)
+    {
+        if (packetTracing)
+            renderTilePackets(tile, rs);
+        else
+            renderTile(tile, rs);
+    });
+}
+
+const FilmBuffer& Raytracer::getFilm() const
+{
+    return film;
+}
 
+void Raytracer::setToneMapper(const ToneMapper& toneMapper)
+{
+    this->toneMapper = toneMapper;
+}
+
+const ToneMapper& Raytracer::getToneMapper() const
+{
+    return toneMapper;
+}
+
+void Raytracer::toneMap(Image& img) const
+{
+    toneMapper.apply(film, img);
+}
+
+void Raytracer::renderTiles(uint32_t width, uint32_t height, const std::function<void(const Tile&)>& work)
+{
+    // every tile writes a disjoint set of pixels and its own stats entry,
+    // so the workers never touch the same memory
+    forEachTile(width, height, nullptr, [&](const Tile& tile, uint32_t worker)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        work(tile);
+        const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        tileStats[tile.index] = TileStats{ tile.x0, tile.y0, tile.x1, tile.y1, worker,
+                                           tileStats[tile.index].milliseconds + duration.count() };
+    });
+}
+
+int Raytracer::getSampleCount() const
+{
+    return numSamplesX * numSamplesY;
+}
+
+void Raytracer::setAdaptiveSampling(const AdaptiveSampling& adaptiveSampling)
+{
+    this->adaptiveSampling = adaptiveSampling;
+}
+
+const AdaptiveSampling& Raytracer::getAdaptiveSampling() const
+{
+    return adaptiveSampling;
+}
+
+Image Raytracer::getSampleHeatmap() const
+{
+    return film.getSampleHeatmap();
+}
+
+double Raytracer::getAverageSampleCount() const
+{
+    return film.getAverageSampleCount();
+}
+
+void Raytracer::accumulateSample(FilmBuffer& film, int sample,
+                                 const std::atomic<bool>& cancel, const std::function<void(const Tile&)>& onTile)
+{
+    const uint32_t width = film.getWidth();
+    const uint32_t height = film.getHeight();
+    RaySetup rs = computeRaySetup(width, height);
+
+    // same sample order and positions as renderTile
+    forEachTile(width, height, &cancel, [&](const Tile& tile, uint32_t)
+    {
+        for (uint32_t y = tile.y0; y < tile.y1; ++y)
+        {
+            if (packetTracing)
+            {
+                for (uint32_t x = tile.x0; x < tile.x1; x += PACKET_SIZE)
+                {
+                    const uint32_t lanes = std::min(PACKET_SIZE, tile.x1 - x);
+                    RayPacket packet;
+                    for (uint32_t lane = 0; lane < lanes; ++lane)
+                    {
+                        const Vec2 offset = sampleOffset(x + lane, y, sample);
+                        packet.set(lane, computeRay((x + lane) + offset.x, y + offset.y, rs));
+                    }
+                    packet.fillInactive();
+                    Vec3 colors[PACKET_SIZE];
+                    tracePacket(packet, x, y, sample, colors);
+                    for (uint32_t lane = 0; lane < lanes; ++lane)
+                        film.addSample(x + lane, y, colors[lane]);
+                }
+            }
+            else
+            {
+                for (uint32_t x = tile.x0; x < tile.x1; ++x)
+                {
+                    const Vec2 offset = sampleOffset(x, y, sample);
+                    film.addSample(x, y, traceRay(computeRay(x + offset.x, y + offset.y, rs), x, y, sample));
+                }
+            }
+        }
+        if (onTile)
+            onTile(tile);
+    });
+}
+
+void Raytracer::forEachTile(uint32_t width, uint32_t height, const std::atomic<bool>* cancel,
+                            const std::function<void(const Tile&, uint32_t)>& work)
+{
+    const uint32_t workerCount = getThreadCount();
+    TileScheduler scheduler(width, height, tileSize, workerCount);
+
+    auto worker = [&](uint32_t id)
+    {
+        std::optional<Tile> tile;
+        while ((!cancel || !cancel->load()) && (tile = scheduler.next(id)).has_value())
+            work(tile.value(), id);
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t id = 1; id < workerCount; ++id)
+        threads.emplace_back(worker, id);
+    worker(0);
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void Raytracer::renderTile(const Tile& tile, const RaySetup& rs)
+{
     int numSamples = numSamplesX * numSamplesY;
-    for (uint32_t y = 0; y < img.height; ++y)
+    for (uint32_t y = tile.y0; y < tile.y1; ++y)
     {
-        for (uint32_t x = 0; x < img.width; ++x)
+        for (uint32_t x = tile.x0; x < tile.x1; ++x)
         {
             Vec3 color;
             if (numSamples == 1)
             {
-                Ray r = computeRay(float(x), float(y), rs);
-                color = traceRay(r);
+                const Vec2 offset = sampleOffset(x, y, 0);
+                Ray r = computeRay(x + offset.x, y + offset.y, rs);
+                color = traceRay(r, x, y, 0);
             }
             else
             {
-                for (int sY = 0; sY < numSamplesY; ++sY)
+                for (int sample = 0; sample < numSamples; ++sample)
                 {
-                    for (int sX = 0; sX < numSamplesX; ++sX)
-                    {
-                        Ray r = computeRay(x + sX / ((float)numSamplesX), y + sY / ((float)numSamplesY), rs);
-                        color = color + traceRay(r);
-                    }
+                    const Vec2 offset = sampleOffset(x, y, sample);
+                    Ray r = computeRay(x + offset.x, y + offset.y, rs);
+                    color = color + traceRay(r, x, y, sample);
+                }
+            }
+            film.addSamples(x, y, color, uint32_t(numSamples));
+        }
+    }
+}
+
+void Raytracer::renderTilePackets(const Tile& tile, const RaySetup& rs)
+{
+    // same sample positions and summation order as renderTile
+    int numSamples = numSamplesX * numSamplesY;
+    for (uint32_t y = tile.y0; y < tile.y1; ++y)
+    {
+        for (uint32_t x = tile.x0; x < tile.x1; x += PACKET_SIZE)
+        {
+            const uint32_t lanes = std::min(PACKET_SIZE, tile.x1 - x);
+            Vec3 colors[PACKET_SIZE];
+            Vec3 sampleColors[PACKET_SIZE];
+            for (int sample = 0; sample < numSamples; ++sample)
+            {
+                RayPacket packet;
+                for (uint32_t lane = 0; lane < lanes; ++lane)
+                {
+                    const Vec2 offset = sampleOffset(x + lane, y, sample);
+                    packet.set(lane, computeRay((x + lane) + offset.x, y + offset.y, rs));
                 }
-                color = color / float(numSamples);
+                packet.fillInactive();
+                tracePacket(packet, x, y, sample, sampleColors);
+                for (uint32_t lane = 0; lane < lanes; ++lane)
+                    colors[lane] = numSamples == 1 ? sampleColors[lane] : colors[lane] + sampleColors[lane];
             }
-            img.setNormalizedValue(x, y, 0, color.r);
-            img.setNormalizedValue(x, y, 1, color.g);
-            img.setNormalizedValue(x, y, 2, color.b);
-            img.setValue(x, y, 3, 255);
+
+            for (uint32_t lane = 0; lane < lanes; ++lane)
+                film.addSamples(x + lane, y, colors[lane], uint32_t(numSamples));
         }
     }
 }
 
-Vec3 Raytracer::traceRay(const Ray& r)
+void Raytracer::renderAdaptive(const RaySetup& rs)
+{
+    const uint32_t width = film.getWidth();
+    const uint32_t height = film.getHeight();
+
+    // two samples are the least that allow a variance estimate
+    const int minSamples = std::max(2, adaptiveSampling.minSamples);
+    const int maxSamples = std::max(1, adaptiveSampling.maxSamples);
+    std::vector<PixelEstimate> estimates(size_t(width) * height);
+
+    // first pass: sample every pixel until its own estimate is good enough
+    renderTiles(width, height, [&](const Tile& tile)
+    {
+        for (uint32_t y = tile.y0; y < tile.y1; ++y)
+            for (uint32_t x = tile.x0; x < tile.x1; ++x)
+                refinePixel(estimates[size_t(y) * width + x], x, y, rs, minSamples, maxSamples);
+    });
+
+    // two samples on the same side of an edge look converged, so the variance
+    // test misses some edge pixels, comparing with the neighbors catches them
+    std::vector<float> meanLuminance(estimates.size());
+    for (uint32_t y = 0; y < height; ++y)
+        for (uint32_t x = 0; x < width; ++x)
+            meanLuminance[size_t(y) * width + x] = estimates[size_t(y) * width + x].lumSum / float(film.getSampleCount(x, y));
+
+    // second pass: refine pixels with a strong contrast to a neighbor
+    renderTiles(width, height, [&](const Tile& tile)
+    {
+        for (uint32_t y = tile.y0; y < tile.y1; ++y)
+        {
+            for (uint32_t x = tile.x0; x < tile.x1; ++x)
+            {
+                const size_t index = size_t(y) * width + x;
+
+                float contrast = 0.0f;
+                if (x > 0) contrast = std::max(contrast, std::abs(meanLuminance[index] - meanLuminance[index - 1]));
+                if (x + 1 < width) contrast = std::max(contrast, std::abs(meanLuminance[index] - meanLuminance[index + 1]));
+                if (y > 0) contrast = std::max(contrast, std::abs(meanLuminance[index] - meanLuminance[index - width]));
+                if (y + 1 < height) contrast = std::max(contrast, std::abs(meanLuminance[index] - meanLuminance[index + width]));
+                if (contrast > adaptiveSampling.contrastThreshold)
+                    refinePixel(estimates[index], x, y, rs, maxSamples, maxSamples);
+            }
+        }
+    });
+}
+
+void Raytracer::refinePixel(PixelEstimate& estimate, uint32_t x, uint32_t y, const RaySetup& rs, int minSamples, int maxSamples)
+{
+    const float threshold = adaptiveSampling.threshold;
+    uint32_t n = film.getSampleCount(x, y);
+
+    // with jitter every pixel shifts the sequence by its own random offset (Cranley-Patterson rotation)
+    Vec2 shift{ 0.0f, 0.0f };
+    if (jitter)
+    {
+        SampleRandom random(x, y, 0, 0, seed);
+        shift = Vec2{ random.nextFloat(), random.nextFloat() };
+    }
+
+    while (n < uint32_t(maxSamples))
+    {
+        float u = radicalInverse(n, 2) + shift.x;
+        float v = radicalInverse(n, 3) + shift.y;
+        if (u >= 1.0f) u -= 1.0f;
+        if (v >= 1.0f) v -= 1.0f;
+        Ray r = computeRay(x + u, y + v, rs);
+        const Vec3 sample = traceRay(r, x, y, int(n));
+        const float lum = luminance(sample);
+        film.addSample(x, y, sample);
+        estimate.lumSum += lum;
+        estimate.lumSqSum += lum * lum;
+        ++n;
+
+        if (n < uint32_t(minSamples))
+            continue;
+        // stop once the standard error of the mean, sqrt(variance / count), is small enough
+        const float count = float(n);
+        const float mean = estimate.lumSum / count;
+        const float variance = std::max(0.0f, (estimate.lumSqSum - count * mean * mean) / (count - 1.0f));
+        if (variance <= threshold * threshold * count)
+            return;
+    }
+}
+
+/// <summary>
+/// Position of a subsample inside its pixel: the corner of its cell of the
+/// sample grid, or a random point inside that cell with jitter enabled.
+/// </summary>
+Vec2 Raytracer::sampleOffset(uint32_t x, uint32_t y, int sample) const
+{
+    const int sX = sample % numSamplesX;
+    const int sY = sample / numSamplesX;
+    if (!jitter)
+    {
+        if (numSamplesX * numSamplesY == 1)
+            return Vec2{ 0.0f, 0.0f };
+        return Vec2{ sX / ((float)numSamplesX), sY / ((float)numSamplesY) };
+    }
+
+    SampleRandom random(x, y, uint32_t(sample), 0, seed);
+    const float jitterX = random.nextFloat();
+    const float jitterY = random.nextFloat();
+    return Vec2{ (sX + jitterX) / ((float)numSamplesX), (sY + jitterY) / ((float)numSamplesY) };
+}
+
+/// <summary>
+/// Traces the camera ray of subsample sample of pixel (x, y). The shading
+/// at its first hit draws from the stream of bounce 1, bounce 0 is used by
+/// sampleOffset to place the ray.
+/// </summary>
+Vec3 Raytracer::traceRay(const Ray& r, uint32_t x, uint32_t y, int sample) const
+{
+    SampleRandom random(x, y, uint32_t(sample), 1, seed);
+    return scene.traceRay(r, 1.0, recDepth, &random);
+}
+
+/// <summary>
+/// Packet version of traceRay, lane i holds the ray of pixel (x + i, y).
+/// </summary>
+void Raytracer::tracePacket(const RayPacket& packet, uint32_t x, uint32_t y, int sample, Vec3* colors) const
 {
-    return scene.traceRay(r, 1.0, recDepth);
+    SampleRandom randoms[PACKET_SIZE];
+    for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane)
+        randoms[lane] = SampleRandom(x + lane, y, uint32_t(sample), 1, seed);
+    scene.tracePacket(packet, 1.0, recDepth, colors, randoms);
 }
 
 Ray Raytracer::computeRay(float x, float y, const RaySetup& rs) const
@@ -59,7 +451,7 @@ Ray Raytracer::computeRay(float x, float y, const RaySetup& rs) const
     return Ray{ rs.rayOrigin, dir };
 }
 
-RaySetup Raytracer::computeRaySetup(const Image& img)
+RaySetup Raytracer::computeRaySetup(uint32_t width, uint32_t height)
 {
     RaySetup rs;
 
@@ -68,15 +460,15 @@ RaySetup Raytracer::computeRaySetup(const Image& img)
     float openingAngle = float(camera.getFoV() * M_PI/180.0);
     rs.rayOrigin = camera.getEyePoint();
 
-    float aspectRatio = ((float)img.width) / ((float)img.height);
+    float aspectRatio = ((float)width) / ((float)height);
 
     Vec3 rightDir = Vec3::cross(forwardDir, upDir);
 
     Vec3 rowVector = rightDir * (tan(openingAngle / 2.0f) * aspectRatio);
     Vec3 columnVector = upDir * (tan(openingAngle / 2.0f));
 
-    rs.dX = rowVector * 2.0f / (float)img.width;
-    rs.dY = columnVector * 2.0f / (float)img.height;
+    rs.dX = rowVector * 2.0f / (float)width;
+    rs.dY = columnVector * 2.0f / (float)height;
 
     rs.bottomLeft = forwardDir - columnVector - rowVector;
 
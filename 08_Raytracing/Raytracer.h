@@ -1,9 +1,17 @@
 #pragma once
+#include <Vec2.h>
 #include <Vec3.h>
 #include <Image.h>
 
+#include <atomic>
+#include <functional>
+#include <vector>
+
 #include "Camera.h"
+#include "FilmBuffer.h"
 #include "Scene.h"
+#include "TileScheduler.h"
+#include "ToneMapper.h"
 
 
 struct RaySetup
@@ -15,18 +23,57 @@ public:
 	Vec3 dY;
 };
 
+/// <summary>
+/// Timing of a single tile of the last call to Raytracer::render, used to
+/// spot load imbalance between the regions of the image.
+/// </summary>
+struct TileStats
+{
+	uint32_t x0;
+	uint32_t y0;
+	uint32_t x1;
+	uint32_t y1;
+	uint32_t worker;
+	double milliseconds;
+};
+
+/// <summary>
+/// Settings of the adaptive sampler. Every pixel gets at least minSamples
+/// samples, more are taken until the standard error of the mean luminance
+/// drops to threshold or maxSamples is reached. Afterwards pixels whose mean
+/// luminance differs from a neighbor by more than contrastThreshold are
+/// refined to maxSamples.
+/// </summary>
+struct AdaptiveSampling
+{
+	bool enabled = false;
+	int minSamples = 2;
+	int maxSamples = 16;
+	float threshold = 0.01f;
+	float contrastThreshold = 0.1f;
+};
+
 class Raytracer
 {
 private:
 	int recDepth;
 	int numSamplesX;
 	int numSamplesY;
+	uint32_t threadCount;
+	uint32_t tileSize;
+	bool packetTracing;
+	bool jitter;
+	uint32_t seed;
+	AdaptiveSampling adaptiveSampling;
 	Camera camera;
 	Scene scene;
+	std::vector<TileStats> tileStats;
+	FilmBuffer film;
+	ToneMapper toneMapper;
 
 public:
 	Raytracer(int recDepth, int numSamples)
-		: recDepth(recDepth)
+		: recDepth(recDepth), threadCount(0), tileSize(32), packetTracing(false), jitter(false), seed(0)
 	{
 		numSamplesX = (int)sqrtf(float(numSamples));
 		numSamplesY = numSamples / numSamplesX;
@@ -34,11 +81,104 @@ public:
 
 	void setCamera(const Camera& camera);
 	void setScene(const Scene& scene);
+	const Scene& getScene() const;
+
+	/// <summary>
+	/// Renders into the film and tone maps the film into img.
+	/// </summary>
 	void render(Image& img);
 
+	/// <summary>
+	/// Renders into the film only, it can be tone mapped any number of times afterwards.
+	/// </summary>
+	void render(uint32_t width, uint32_t height);
+	const FilmBuffer& getFilm() const;
+
+	/// <summary>
+	/// Tone mapper used by render, toneMap applies it to the film of the last
+	/// render again, e.g. after a change of the exposure.
+	/// </summary>
+	void setToneMapper(const ToneMapper& toneMapper);
+	const ToneMapper& getToneMapper() const;
+	void toneMap(Image& img) const;
+
+	/// <summary>
+	/// Sets the number of worker threads used by render, 0 selects the number of hardware threads.
+	/// </summary>
+	void setThreadCount(uint32_t threadCount);
+	uint32_t getThreadCount() const;
+	void setTileSize(uint32_t tileSize);
+	uint32_t getTileSize() const;
+	const std::vector<TileStats>& getTileStats() const;
+
+	/// <summary>
+	/// In packet mode eight neighboring pixels of a row are traced together,
+	/// one packet per subsample. The image is the same as in scalar mode.
+	/// </summary>
+	void setPacketTracing(bool packetTracing);
+	bool getPacketTracing() const;
+	void setSIMDLevel(SIMDLevel level);
+
+	/// <summary>
+	/// Number of subsamples per pixel, render averages all of them.
+	/// </summary>
+	int getSampleCount() const;
+
+	/// <summary>
+	/// With jitter enabled every subsample is moved to a random position
+	/// inside its cell of the sample grid (or the Halton sequence of adaptive
+	/// sampling is shifted per pixel). The numbers come from a SampleRandom
+	/// keyed by pixel and subsample, so the image only depends on the seed and
+	/// not on the tile size, the thread count or the order of the passes. The
+	/// seed also selects the streams of the light sampling, see
+	/// Scene::setLightSampling.
+	/// </summary>
+	void setJitter(bool jitter, uint32_t seed = 0);
+	bool getJitter() const;
+
+	/// <summary>
+	/// With adaptive sampling enabled render ignores the fixed sample grid
+	/// and packet mode and places the samples of every pixel on a Halton
+	/// sequence instead, taking only as many as the pixel needs.
+	/// </summary>
+	void setAdaptiveSampling(const AdaptiveSampling& adaptiveSampling);
+	const AdaptiveSampling& getAdaptiveSampling() const;
+
+	/// <summary>
+	/// Number of samples every pixel received in the last call to render,
+	/// see FilmBuffer::getSampleHeatmap.
+	/// </summary>
+	Image getSampleHeatmap() const;
+	double getAverageSampleCount() const;
+
+	/// <summary>
+	/// Traces subsample sample (0 <= sample < getSampleCount()) of every pixel
+	/// and adds its color to the pixels of film. Accumulating all subsamples
+	/// in order gives exactly the film of render. The worker threads call
+	/// onTile for every finished tile, no further tiles are started once
+	/// cancel is set.
+	/// </summary>
+	void accumulateSample(FilmBuffer& film, int sample,
+	                      const std::atomic<bool>& cancel, const std::function<void(const Tile&)>& onTile);
+
 private:
-	Vec3 traceRay(const Ray& r);
+	void renderTile(const Tile& tile, const RaySetup& rs);
+	void renderTilePackets(const Tile& tile, const RaySetup& rs);
+	void renderTiles(uint32_t width, uint32_t height, const std::function<void(const Tile&)>& work);
+
+	struct PixelEstimate
+	{
+		float lumSum = 0.0f;
+		float lumSqSum = 0.0f;
+	};
+	void renderAdaptive(const RaySetup& rs);
+	void refinePixel(PixelEstimate& estimate, uint32_t x, uint32_t y, const RaySetup& rs, int minSamples, int maxSamples);
+	Vec2 sampleOffset(uint32_t x, uint32_t y, int sample) const;
+	Vec3 traceRay(const Ray& r, uint32_t x, uint32_t y, int sample) const;
+	void tracePacket(const RayPacket& packet, uint32_t x, uint32_t y, int sample, Vec3* colors) const;
 	Ray computeRay(float x, float y, const RaySetup& rs) const;
-	RaySetup computeRaySetup(const Image& img);
+	RaySetup computeRaySetup(uint32_t width, uint32_t height);
+	void forEachTile(uint32_t width, uint32_t height, const std::atomic<bool>* cancel,
+	                 const std::function<void(const Tile&, uint32_t)>& work);
 };
 
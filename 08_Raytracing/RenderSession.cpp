@@ -0,0 +1,106 @@
+#include "RenderSession.h"
+
+RenderSession::RenderSession(const Raytracer& raytracer, uint32_t width, uint32_t height)
+	: raytracer(raytracer), width(width), height(height),
+	toneMapper(raytracer.getToneMapper()), snapshot(width, height, 4), snapshotVersion(0), deliveredVersion(0),
+	cancelled(false), completedSamples(0)
+{
+}
+
+RenderSession::~RenderSession()
+{
+	cancel();
+}
+
+void RenderSession::start()
+{
+	cancel();
+
+	film.resize(width, height);
+	cancelled = false;
+	completedSamples = 0;
+
+#ifdef __EMSCRIPTEN__
+	// the web build is compiled without pthread support
+	run();
+#else
+	thread = std::thread(&RenderSession::run, this);
+#endif
+}
+
+void RenderSession::cancel()
+{
+	cancelled = true;
+	if (thread.joinable())
+		thread.join();
+}
+
+void RenderSession::restart(const Camera& camera)
+{
+	cancel();
+	raytracer.setCamera(camera);
+	start();
+}
+
+bool RenderSession::update(Image& image)
+{
+	std::scoped_lock lock(snapshotMutex);
+	if (snapshotVersion == deliveredVersion)
+		return false;
+	image = snapshot;
+	deliveredVersion = snapshotVersion;
+	return true;
+}
+
+void RenderSession::setToneMapper(const ToneMapper& toneMapper)
+{
+	std::scoped_lock lock(snapshotMutex);
+	this->toneMapper = toneMapper;
+	if (isFinished())
+	{
+		toneMapper.apply(film, snapshot);
+		++snapshotVersion;
+	}
+}
+
+ToneMapper RenderSession::getToneMapper()
+{
+	std::scoped_lock lock(snapshotMutex);
+	return toneMapper;
+}
+
+int RenderSession::getCompletedSamples() const
+{
+	return completedSamples;
+}
+
+int RenderSession::getSampleCount() const
+{
+	return raytracer.getSampleCount();
+}
+
+bool RenderSession::isFinished() const
+{
+	return completedSamples == raytracer.getSampleCount();
+}
+
+void RenderSession::run()
+{
+	const int sampleCount = raytracer.getSampleCount();
+	for (int sample = 0; sample < sampleCount && !cancelled; ++sample)
+	{
+		raytracer.accumulateSample(film, sample, cancelled,
+			[this](const Tile& tile) { publish(tile); });
+		if (!cancelled)
+			completedSamples = sample + 1;
+	}
+}
+
+void RenderSession::publish(const Tile& tile)
+{
+	// the pixels of a tile are only written by the worker that renders it,
+	// so they can be read here without holding a lock on the film
+	std::scoped_lock lock(snapshotMutex);
+	toneMapper.apply(film, snapshot, tile);
+	++snapshotVersion;
+}
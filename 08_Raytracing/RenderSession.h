@@ -0,0 +1,82 @@
+#pragma once
+#include <Image.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "Camera.h"
+#include "FilmBuffer.h"
+#include "Raytracer.h"
+#include "ToneMapper.h"
+
+/// <summary>
+/// Progressive rendering in the background. The session renders one
+/// subsample of every pixel per pass and adds it to a FilmBuffer. Whenever
+/// a tile of a pass is finished, the average of all passes so far is tone
+/// mapped into a snapshot image, which the GUI thread fetches with update.
+/// Once all passes are done the snapshot equals the image of Raytracer::render.
+/// </summary>
+class RenderSession
+{
+private:
+	Raytracer raytracer;
+	uint32_t width;
+	uint32_t height;
+	FilmBuffer film;
+
+	std::mutex snapshotMutex;
+	ToneMapper toneMapper;	// guarded by snapshotMutex
+	Image snapshot;
+	uint64_t snapshotVersion;	// increased with every change of snapshot
+	uint64_t deliveredVersion;	// version last copied by update
+
+	std::atomic<bool> cancelled;
+	std::atomic<int> completedSamples;
+	std::thread thread;
+
+public:
+	RenderSession(const Raytracer& raytracer, uint32_t width, uint32_t height);
+	~RenderSession();
+
+	RenderSession(const RenderSession&) = delete;
+	RenderSession& operator=(const RenderSession&) = delete;
+
+	/// <summary>
+	/// Starts rendering from scratch, a running session is cancelled first.
+	/// </summary>
+	void start();
+
+	/// <summary>
+	/// Stops the session, waits for the tiles in flight to finish.
+	/// </summary>
+	void cancel();
+
+	/// <summary>
+	/// Cancels the session and starts over with a new camera.
+	/// </summary>
+	void restart(const Camera& camera);
+
+	/// <summary>
+	/// Copies the snapshot into image if it changed since the last call and
+	/// returns true in that case.
+	/// </summary>
+	bool update(Image& image);
+
+	/// <summary>
+	/// Changes the tone mapping of the snapshot. A finished film is mapped
+	/// again right away without tracing any rays, while rendering the new
+	/// mapping is picked up tile by tile.
+	/// </summary>
+	void setToneMapper(const ToneMapper& toneMapper);
+	ToneMapper getToneMapper();
+
+	int getCompletedSamples() const;
+	int getSampleCount() const;
+	bool isFinished() const;
+
+private:
+	void run();
+	void publish(const Tile& tile);
+};
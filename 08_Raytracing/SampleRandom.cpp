@@ -0,0 +1,53 @@
+#include "SampleRandom.h"
+
+namespace {
+
+constexpr uint32_t PHILOX_M0 = 0xD2511F53u;
+constexpr uint32_t PHILOX_M1 = 0xCD9E8D57u;
+constexpr uint32_t PHILOX_W0 = 0x9E3779B9u;
+constexpr uint32_t PHILOX_W1 = 0xBB67AE85u;
+
+void mulhilo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo)
+{
+    const uint64_t product = uint64_t(a) * uint64_t(b);
+    hi = uint32_t(product >> 32);
+    lo = uint32_t(product);
+}
+
+}
+
+SampleRandom::SampleRandom(uint32_t x, uint32_t y, uint32_t sample, uint32_t bounce, uint32_t seed)
+    : counter{ x, y, sample, bounce }, seed(seed), block(0), buffer{}, used(4)
+{
+}
+
+uint32_t SampleRandom::next()
+{
+    // the block index goes into the key, so the counter stays free for the
+    // four coordinates of the sample
+    if (used == 4)
+    {
+        buffer = philox(counter, { seed, block++ });
+        used = 0;
+    }
+    return buffer[used++];
+}
+
+float SampleRandom::nextFloat()
+{
+    return float(next() >> 8) * (1.0f / 16777216.0f);
+}
+
+std::array<uint32_t, 4> SampleRandom::philox(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key)
+{
+    for (int round = 0; round < 10; ++round)
+    {
+        uint32_t hi0, lo0, hi1, lo1;
+        mulhilo(PHILOX_M0, counter[0], hi0, lo0);
+        mulhilo(PHILOX_M1, counter[2], hi1, lo1);
+        counter = { hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0 };
+        key[0] += PHILOX_W0;
+        key[1] += PHILOX_W1;
+    }
+    return counter;
+}
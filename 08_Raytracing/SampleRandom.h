@@ -0,0 +1,39 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+/// <summary>
+/// Counter based random numbers (Philox 4x32-10). Unlike a Random with its
+/// std::mt19937 the numbers carry no state from one pixel to the next: the
+/// stream of a sample is a pure function of its pixel, its subsample index,
+/// the bounce it is used at and the seed. Any split of the image into tiles,
+/// threads or processes therefore draws exactly the same numbers.
+/// </summary>
+class SampleRandom
+{
+private:
+	std::array<uint32_t, 4> counter;
+	uint32_t seed;
+	uint32_t block;
+	std::array<uint32_t, 4> buffer;
+	uint32_t used;
+
+public:
+	SampleRandom() : SampleRandom(0, 0, 0, 0) {}
+	SampleRandom(uint32_t x, uint32_t y, uint32_t sample, uint32_t bounce, uint32_t seed = 0);
+
+	/// <summary>
+	/// Next number of the stream, every call to philox yields four of them.
+	/// </summary>
+	uint32_t next();
+
+	/// <summary>
+	/// Uniform float in [0, 1) with 24 bits of randomness.
+	/// </summary>
+	float nextFloat();
+
+	/// <summary>
+	/// The raw block function: ten rounds of Philox 4x32 on counter with key.
+	/// </summary>
+	static std::array<uint32_t, 4> philox(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key);
+};
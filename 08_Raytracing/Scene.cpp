@@ -3,11 +3,20 @@
 #include "PointLight.h"
 #include "Sphere.h"
 #include "Plane.h"
+#include "TriangleMesh.h"
+#include "Instance.h"
+#include "ObjectGroup.h"
 
+#include <Rand.h>
 #include <iostream>
 
 void Scene::addObject(std::shared_ptr<const IntersectableObject> object) {
+  objectMaterials.push_back(uint32_t(materials.size()));
+  materials.push_back(object->getMaterial());
   sceneObjects.push_back(object);
+  shadowCasters.push_back(materials.back().isShadowCaster());
+  bvh.reset();
+  prebuiltBVH.reset();
 }
 
 void Scene::addLight(std::shared_ptr<const LightSource> ls) {
@@ -18,19 +27,297 @@ Vec3 Scene::getBackgroundcolor() const {
   return backgroundColor;
 }
 
+const std::vector<std::shared_ptr<const IntersectableObject>>& Scene::getObjects() const {
+  return sceneObjects;
+}
+
+const std::vector<std::shared_ptr<const LightSource>>& Scene::getLights() const {
+  return lightSources;
+}
+
+const Material& Scene::getMaterial(uint32_t materialID) const {
+  return materials[materialID];
+}
+
+size_t Scene::getMaterialCount() const {
+  return materials.size();
+}
+
+void Scene::buildAccelerationStructure() {
+  boundedObjects.clear();
+  unboundedObjects.clear();
+
+  std::vector<AABB> bounds;
+  for (uint32_t i = 0; i < uint32_t(sceneObjects.size()); ++i) {
+    std::optional<AABB> b = sceneObjects[i]->getBounds();
+    if (b.has_value()) {
+      boundedObjects.push_back(i);
+      bounds.push_back(b.value());
+    } else {
+      unboundedObjects.push_back(i);
+    }
+  }
+  if (prebuiltBVH && prebuiltBVH->getBuildStats().primitiveCount == bounds.size())
+    bvh = prebuiltBVH;
+  else
+    bvh = std::make_shared<const BVH>(bounds);
+
+  compiled.build(sceneObjects, objectMaterials, materials);
+  buildLightTree();
+}
+
+void Scene::buildLightTree() {
+  treeLights.clear();
+  otherLights.clear();
+  treeAmbient = Vec3{ 0.0f, 0.0f, 0.0f };
+
+  std::vector<Vec3> positions;
+  std::vector<float> powers;
+  for (uint32_t i = 0; i < uint32_t(lightSources.size()); ++i) {
+    const PointLight* pointLight = dynamic_cast<const PointLight*>(lightSources[i].get());
+    if (!pointLight) {
+      otherLights.push_back(i);
+      continue;
+    }
+    // the power only steers the sampling, the luminance of the light colors is good enough
+    const Vec3 color = pointLight->getDiffuse() + pointLight->getSpecular();
+    treeLights.push_back(i);
+    positions.push_back(pointLight->getPosition());
+    powers.push_back(0.2126f * color.r + 0.7152f * color.g + 0.0722f * color.b);
+    treeAmbient = treeAmbient + pointLight->getAmbient();
+  }
+  lightTree = LightTree(positions, powers);
+}
+
+void Scene::setLightSampling(const LightSampling& lightSampling) {
+  this->lightSampling = lightSampling;
+}
+
+const LightSampling& Scene::getLightSampling() const {
+  return lightSampling;
+}
+
+size_t Scene::getLightCount() const {
+  return lightSources.size();
+}
+
+bool Scene::samplesLights() const {
+  return lightSampling.enabled && lightSampling.shadowRays > 0 && !lightTree.isEmpty();
+}
+
+void Scene::setIntersectionMode(IntersectionMode mode) {
+  intersectionMode = mode;
+}
+
+IntersectionMode Scene::getIntersectionMode() const {
+  return intersectionMode;
+}
+
+BVHBuildStats Scene::getBuildStats() const {
+  return bvh ? bvh->getBuildStats() : BVHBuildStats{};
+}
+
+void Scene::setPrebuiltHierarchy(std::shared_ptr<const BVH> hierarchy) {
+  prebuiltBVH = hierarchy;
+}
+
+std::shared_ptr<const BVH> Scene::getHierarchy() const {
+  return bvh;
+}
+
 std::optional<Intersection> Scene::intersect(const Ray& ray, bool shadowRay) const {
+  return intersect(ray, shadowRay, nullptr);
+}
+
+std::optional<Intersection> Scene::intersect(const Ray& ray, bool shadowRay, BVHTraversalStats* stats) const {
+  // without a compiled scene only the virtual methods of the objects are available
+  if (!bvh)
+    return intersectLinear(ray, shadowRay);
+
+  if (intersectionMode == IntersectionMode::LINEAR) {
+    const CompiledHit hit = compiled.intersect(ray, shadowRay);
+    if (hit.object < 0)
+      return {};
+    return compiled.makeIntersection(uint32_t(hit.object), ray, hit.t, hit.intersection);
+  }
+
+  return intersectBVH(ray, shadowRay, stats);
+}
+
+std::optional<Intersection> Scene::intersectBVH(const Ray& ray, bool shadowRay, BVHTraversalStats* stats) const {
+  CompiledHit result;
+
+  // on equal distances the object added first wins, just like in the linear loop
+  auto test = [&](uint32_t index) {
+    if (shadowRay && !shadowCasters[index])
+      return;
+
+    float t;
+    std::optional<Intersection> intersection;
+    if (!compiled.intersect(index, ray, t, intersection))
+      return;
+
+    if (result.object < 0 || t < result.t || (t == result.t && int32_t(index) < result.object)) {
+      result.t = t;
+      result.object = int32_t(index);
+      result.intersection = intersection;
+    }
+  };
+
+  for (uint32_t index : unboundedObjects)
+    test(index);
+
+  bvh->traverse(ray, result.t, [&](uint32_t primitive, float& tMax) {
+    test(boundedObjects[primitive]);
+    tMax = result.t;
+    return false;
+  }, stats);
+
+  // only the closest hit pays for normal and material
+  if (result.object < 0)
+    return {};
+  return compiled.makeIntersection(uint32_t(result.object), ray, result.t, result.intersection);
+}
+
+bool Scene::occluded(const Ray& ray, float maxT) const {
+  if (!bvh) {
+    for (size_t i = 0; i < sceneObjects.size(); ++i) {
+      if (shadowCasters[i] && sceneObjects[i]->hits(ray, maxT))
+        return true;
+    }
+    return false;
+  }
+
+  if (intersectionMode == IntersectionMode::LINEAR)
+    return compiled.occluded(ray, maxT);
+
+  for (uint32_t index : unboundedObjects) {
+    if (shadowCasters[index] && compiled.hits(index, ray, maxT))
+      return true;
+  }
+
+  bool hit = false;
+  bvh->traverse(ray, maxT, [&](uint32_t primitive, float& tMax) {
+    const uint32_t index = boundedObjects[primitive];
+    hit = shadowCasters[index] && compiled.hits(index, ray, tMax);
+    return hit;
+  });
+  return hit;
+}
+
+void Scene::setSIMDLevel(SIMDLevel level) {
+  kernels = &getPacketKernels(level);
+}
+
+void Scene::intersectPacketObject(uint32_t index, const RayPacket& packet, uint32_t mask, PacketHit& hit) const {
+  const PrimitiveRef p = bvh ? compiled.getPrimitive(index) : PrimitiveRef{ PrimitiveKind::GENERIC, 0 };
+  switch (p.kind) {
+    case PrimitiveKind::SPHERE:
+      kernels->intersectSphere(packet, mask, compiled.getSphereCenter(p.slot), compiled.getSphereSqRadius(p.slot), int32_t(index), hit);
+      return;
+    case PrimitiveKind::PLANE:
+      kernels->intersectPlane(packet, mask, compiled.getPlaneNormal(p.slot), compiled.getPlaneD(p.slot), int32_t(index), hit);
+      return;
+    default:
+      break;
+  }
+
+  for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+    if (!(mask & (1u << lane)))
+      continue;
+    std::optional<Intersection> i = sceneObjects[index]->intersect(packet.get(lane));
+    if (!i.has_value())
+      continue;
+    const float t = i.value().getT();
+    if (hit.object[lane] < 0 || t < hit.t[lane] || (t == hit.t[lane] && int32_t(index) < hit.object[lane])) {
+      hit.t[lane] = t;
+      hit.object[lane] = int32_t(index);
+      hit.intersection[lane] = i;
+    }
+  }
+}
+
+uint32_t Scene::hitsPacketObject(uint32_t index, const RayPacket& packet, uint32_t mask, const float* maxT) const {
+  if (!shadowCasters[index])
+    return 0;
+
+  const PrimitiveRef p = bvh ? compiled.getPrimitive(index) : PrimitiveRef{ PrimitiveKind::GENERIC, 0 };
+  switch (p.kind) {
+    case PrimitiveKind::SPHERE:
+      return kernels->hitsSphere(packet, mask, compiled.getSphereCenter(p.slot), compiled.getSphereSqRadius(p.slot), maxT);
+    case PrimitiveKind::PLANE:
+      return kernels->hitsPlane(packet, mask, compiled.getPlaneNormal(p.slot), compiled.getPlaneD(p.slot), maxT);
+    default:
+      break;
+  }
+
+  uint32_t result = 0;
+  for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+    if ((mask & (1u << lane)) && sceneObjects[index]->hits(packet.get(lane), maxT[lane]))
+      result |= 1u << lane;
+  }
+  return result;
+}
+
+void Scene::intersectPacket(const RayPacket& packet, PacketHit& hit) const {
+  const uint32_t count = uint32_t(sceneObjects.size());
+  if (intersectionMode == IntersectionMode::LINEAR || !bvh) {
+    for (uint32_t index = 0; index < count; ++index)
+      intersectPacketObject(index, packet, packet.mask, hit);
+    return;
+  }
+
+  for (uint32_t index : unboundedObjects)
+    intersectPacketObject(index, packet, packet.mask, hit);
+
+  bvh->traversePacket(packet, packet.mask, hit.t, *kernels, [&](uint32_t primitive, uint32_t mask) {
+    intersectPacketObject(boundedObjects[primitive], packet, mask, hit);
+    return 0u;
+  });
+}
+
+uint32_t Scene::occludedPacket(const RayPacket& packet, const float* maxT) const {
+  uint32_t result = 0;
+  if (intersectionMode == IntersectionMode::LINEAR || !bvh) {
+    for (uint32_t index = 0; index < uint32_t(sceneObjects.size()) && result != packet.mask; ++index)
+      result |= hitsPacketObject(index, packet, packet.mask & ~result, maxT);
+    return result;
+  }
+
+  for (uint32_t index : unboundedObjects) {
+    if (result == packet.mask)
+      return result;
+    result |= hitsPacketObject(index, packet, packet.mask & ~result, maxT);
+  }
+
+  bvh->traversePacket(packet, packet.mask & ~result, maxT, *kernels, [&](uint32_t primitive, uint32_t mask) {
+    const uint32_t hits = hitsPacketObject(boundedObjects[primitive], packet, mask, maxT);
+    result |= hits;
+    return hits;
+  });
+  return result;
+}
+
+std::optional<Intersection> Scene::intersectLinear(const Ray& ray, bool shadowRay) const {
   std::optional<Intersection> result{};
-  for (std::shared_ptr<const IntersectableObject> object : sceneObjects) {
-    if (shadowRay && !object->getMaterial().isShadowCaster())
+  size_t resultIndex = 0;
+  for (size_t index = 0; index < sceneObjects.size(); ++index) {
+    if (shadowRay && !shadowCasters[index])
       continue;
 
-    std::optional<Intersection> i = object->intersect(ray);
+    std::optional<Intersection> i = sceneObjects[index]->intersect(ray);
     if (!i.has_value())
       continue;
 
-    if (!result.has_value() || i.value().getT() < result.value().getT())
+    if (!result.has_value() || i.value().getT() < result.value().getT()) {
       result = i;
+      resultIndex = index;
+    }
   }
+
+  // the material is resolved only for the closest hit
+  if (result.has_value())
+    result->setMaterialID(objectMaterials[resultIndex]);
   return result;
 }
 
@@ -41,7 +328,7 @@ std::optional<Intersection> Scene::intersect(const Ray& ray, bool shadowRay) con
 /// <param name="IOR">optical density of the material we are currently travelling in</param>
 /// <param name="recDepth">recursion depth</param>
 /// <returns>final color value computed for this ray</returns>
-Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth) const {
+Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth, SampleRandom* random) const {
   // TODO: implement the missing parts of this method according to the exercise
 
   // no intersection found
@@ -56,29 +343,182 @@ Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth) const {
 
 
   Vec3 localColor{ 0.0f, 0.0f, 0.0f };
-  for (std::shared_ptr<const LightSource> ls : lightSources) {
-    Ray shadowRay{ offSurfacePos, ls->getDirection(offSurfacePos) };
-    std::optional<Intersection> shadowInter = intersect(shadowRay, true);
+  if (!random || !samplesLights()) {
+    for (const std::shared_ptr<const LightSource>& ls : lightSources) {
+      const Vec3 lightDir = ls->getDirection(offSurfacePos);
+      Ray shadowRay{ offSurfacePos, lightDir };
+      const bool inShadow = occluded(shadowRay, ls->getDistance(offSurfacePos));
+      localColor = shadeLight(localColor, ray, inter, lightDir, *ls, inShadow);
+    }
+    return localColor;
+  }
+
+  // many-lights mode: exact ambient, a few shadow rays to lights picked by importance
+  localColor = materials[inter.getMaterialID()].getAmbient() * treeAmbient;
+  for (uint32_t index : otherLights) {
+    const LightSource& ls = *lightSources[index];
+    const Vec3 lightDir = ls.getDirection(offSurfacePos);
+    const bool inShadow = occluded(Ray{ offSurfacePos, lightDir }, ls.getDistance(offSurfacePos));
+    localColor = shadeLight(localColor, ray, inter, lightDir, ls, inShadow);
+  }
+
+  Vec3 sampledColor{ 0.0f, 0.0f, 0.0f };
+  for (uint32_t i = 0; i < lightSampling.shadowRays; ++i) {
+    const LightSample sample = lightTree.sample(offSurfacePos, inter.getNormal(), random->nextFloat());
+    const LightSource& ls = *lightSources[treeLights[sample.light]];
+    const Vec3 lightDir = ls.getDirection(offSurfacePos);
+    if (occluded(Ray{ offSurfacePos, lightDir }, ls.getDistance(offSurfacePos)))
+      continue;
+    Vec3 diffuse, specular;
+    directLight(ray, inter, lightDir, ls, diffuse, specular);
+    sampledColor = sampledColor + (diffuse + specular) / sample.pdf;
+  }
+
+  return localColor + sampledColor / float(lightSampling.shadowRays);
+}
 
-    Vec3 ambient = inter.getMaterial().getAmbient() * ls->getAmbient();
+/// <summary>
+/// Adds the contribution of a single light source to the local color,
+/// lightDir is the direction from the shading point to the light.
+/// </summary>
+Vec3 Scene::shadeLight(const Vec3& localColor, const Ray& ray, const Intersection& inter,
+                       const Vec3& lightDir, const LightSource& ls, bool inShadow) const {
+  const Material& material = materials[inter.getMaterialID()];
+  Vec3 ambient = material.getAmbient() * ls.getAmbient();
+  if (inShadow)
+    return localColor + ambient;
 
-    if (!shadowInter.has_value() || shadowInter->getT() > ls->getDistance(offSurfacePos)) {
-      float d = Vec3::dot(ls->getDirection(offSurfacePos), inter.getNormal());
-      Vec3 diffuse = inter.getMaterial().getDiffuse() * ls->getDiffuse() * d;
-      diffuse = Vec3::clamp(diffuse, 0.0f, 1.0f);
+  Vec3 diffuse, specular;
+  directLight(ray, inter, lightDir, ls, diffuse, specular);
+  return localColor + ambient + diffuse + specular;
+}
 
-      Vec3 Rv = Vec3::reflect(ray.getDirection(), inter.getNormal());
-      float s = pow(std::max(0.0f, Vec3::dot(Rv, ls->getDirection(offSurfacePos))), inter.getMaterial().getExp());
-      Vec3 specular = inter.getMaterial().getSpecular() * ls->getSpecular() * s;
-      specular = Vec3::clamp(specular, 0.0f, 1.0f);
+/// <summary>
+/// Diffuse and specular term of a light source that is not in shadow.
+/// </summary>
+void Scene::directLight(const Ray& ray, const Intersection& inter, const Vec3& lightDir, const LightSource& ls,
+                        Vec3& diffuse, Vec3& specular) const {
+  const Material& material = materials[inter.getMaterialID()];
+  float d = Vec3::dot(lightDir, inter.getNormal());
+  diffuse = material.getDiffuse() * ls.getDiffuse() * d;
+  diffuse = Vec3::clamp(diffuse, 0.0f, 1.0f);
 
-      localColor = localColor + ambient + diffuse + specular;
+  Vec3 Rv = Vec3::reflect(ray.getDirection(), inter.getNormal());
+  float s = pow(std::max(0.0f, Vec3::dot(Rv, lightDir)), material.getExp());
+  specular = material.getSpecular() * ls.getSpecular() * s;
+  specular = Vec3::clamp(specular, 0.0f, 1.0f);
+}
+
+/// <summary>
+/// Packet version of traceRay: the closest hits and the shadow rays of all
+/// lanes are computed together, the shading itself runs per lane.
+/// </summary>
+void Scene::tracePacket(const RayPacket& packet, float IOR, int recDepth, Vec3* colors, SampleRandom* randoms) const {
+  PacketHit hit;
+  intersectPacket(packet, hit);
+
+  std::optional<Intersection> inters[PACKET_SIZE];
+  Vec3 offSurfacePos[PACKET_SIZE];
+  Vec3 localColor[PACKET_SIZE];
+  RayPacket shadowPacket;
+  for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+    if (!(packet.mask & (1u << lane)))
+      continue;
+    colors[lane] = backgroundColor;
+    if (hit.object[lane] < 0)
+      continue;
+
+    // spheres and planes compute normal and material from the t of the
+    // kernel, other objects already returned them with their hit
+    const Ray ray = packet.get(lane);
+    if (bvh) {
+      inters[lane] = compiled.makeIntersection(uint32_t(hit.object[lane]), ray, hit.t[lane], hit.intersection[lane]);
     } else {
-      localColor = localColor + ambient;
+      inters[lane] = hit.intersection[lane];
+      if (inters[lane].has_value())
+        inters[lane]->setMaterialID(objectMaterials[hit.object[lane]]);
+    }
+    if (!inters[lane].has_value())
+      continue;
+
+    Vec3 interPos = ray.getPosOnRay(inters[lane]->getT());
+    offSurfacePos[lane] = interPos + inters[lane]->getNormal() * OFFSET_EPSILON;
+    localColor[lane] = Vec3{ 0.0f, 0.0f, 0.0f };
+    shadowPacket.mask |= 1u << lane;
+  }
+
+  if (shadowPacket.mask == 0)
+    return;
+
+  const bool sampling = randoms && samplesLights();
+  if (sampling) {
+    for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+      if (shadowPacket.mask & (1u << lane))
+        localColor[lane] = materials[inters[lane]->getMaterialID()].getAmbient() * treeAmbient;
     }
   }
 
-  return localColor;
+  // one shadow packet per light that is evaluated exactly
+  Vec3 lightDir[PACKET_SIZE];
+  const size_t exactLights = sampling ? otherLights.size() : lightSources.size();
+  for (size_t i = 0; i < exactLights; ++i) {
+    const LightSource& ls = *lightSources[sampling ? otherLights[i] : i];
+    alignas(32) float maxT[PACKET_SIZE] = {};
+    for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+      if (!(shadowPacket.mask & (1u << lane)))
+        continue;
+      lightDir[lane] = ls.getDirection(offSurfacePos[lane]);
+      shadowPacket.set(lane, Ray{ offSurfacePos[lane], lightDir[lane] });
+      maxT[lane] = ls.getDistance(offSurfacePos[lane]);
+    }
+    shadowPacket.fillInactive();
+
+    const uint32_t inShadow = occludedPacket(shadowPacket, maxT);
+    for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+      if (shadowPacket.mask & (1u << lane))
+        localColor[lane] = shadeLight(localColor[lane], packet.get(lane), inters[lane].value(),
+                                      lightDir[lane], ls, (inShadow & (1u << lane)) != 0);
+    }
+  }
+
+  // many-lights mode: every lane picks its own light for each shadow packet
+  if (sampling) {
+    Vec3 sampledColor[PACKET_SIZE];
+    for (uint32_t i = 0; i < lightSampling.shadowRays; ++i) {
+      const LightSource* lights[PACKET_SIZE] = {};
+      float pdf[PACKET_SIZE] = {};
+      alignas(32) float maxT[PACKET_SIZE] = {};
+      for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+        if (!(shadowPacket.mask & (1u << lane)))
+          continue;
+        const LightSample sample = lightTree.sample(offSurfacePos[lane], inters[lane]->getNormal(), randoms[lane].nextFloat());
+        lights[lane] = lightSources[treeLights[sample.light]].get();
+        pdf[lane] = sample.pdf;
+        lightDir[lane] = lights[lane]->getDirection(offSurfacePos[lane]);
+        shadowPacket.set(lane, Ray{ offSurfacePos[lane], lightDir[lane] });
+        maxT[lane] = lights[lane]->getDistance(offSurfacePos[lane]);
+      }
+      shadowPacket.fillInactive();
+
+      const uint32_t inShadow = occludedPacket(shadowPacket, maxT);
+      for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+        if (!(shadowPacket.mask & (1u << lane)) || (inShadow & (1u << lane)))
+          continue;
+        Vec3 diffuse, specular;
+        directLight(packet.get(lane), inters[lane].value(), lightDir[lane], *lights[lane], diffuse, specular);
+        sampledColor[lane] = sampledColor[lane] + (diffuse + specular) / pdf[lane];
+      }
+    }
+    for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+      if (shadowPacket.mask & (1u << lane))
+        localColor[lane] = localColor[lane] + sampledColor[lane] / float(lightSampling.shadowRays);
+    }
+  }
+
+  for (uint32_t lane = 0; lane < PACKET_SIZE; ++lane) {
+    if (shadowPacket.mask & (1u << lane))
+      colors[lane] = localColor[lane];
+  }
 }
 
 Scene Scene::genSimpleScene() {
@@ -123,3 +563,124 @@ Scene Scene::genSimpleScene() {
 
   return s;
 }
+
+Scene Scene::genRandomSpheres(uint32_t count, uint32_t seed) {
+  Scene s = genSimpleScene();
+  Random rnd(seed);
+  for (uint32_t i = 0; i < count; ++i) {
+    Material m(Vec3{ rnd.rand01(), rnd.rand01(), rnd.rand01() } * 0.3f,
+               Vec3{ rnd.rand01(), rnd.rand01(), rnd.rand01() },
+               Vec3{ 1.0f, 1.0f, 1.0f }, 16, 1);
+    const Vec3 center{ rnd.rand11() * 4.0f, rnd.rand11() * 2.0f, -3.0f - rnd.rand01() * 8.0f };
+    s.addObject(std::make_shared<Sphere>(center, 0.05f + rnd.rand01() * 0.2f, m));
+  }
+  return s;
+}
+
+Scene Scene::genManyLights(uint32_t count, uint32_t seed) {
+  Scene s = genSimpleScene();
+  Random rnd(seed);
+  // keep the total intensity of all lights close to the single light of the simple scene
+  const float intensity = 1.0f / float(std::max(1u, count));
+  for (uint32_t i = 0; i < count; ++i) {
+    const Vec3 position{ rnd.rand11() * 6.0f, 1.0f + rnd.rand01() * 5.0f, -rnd.rand01() * 8.0f };
+    const Vec3 color = Vec3{ 0.5f + 0.5f * rnd.rand01(), 0.5f + 0.5f * rnd.rand01(), 0.5f + 0.5f * rnd.rand01() } * intensity;
+    s.addLight(std::make_shared<const PointLight>(position, color * 0.2f, color, color));
+  }
+  return s;
+}
+
+Scene Scene::genDeepReflection() {
+  Scene s;
+  s.addLight(std::make_shared<const PointLight>(Vec3{ 0, 4, -2 },
+                                                Vec3{ 1, 1, 1 },
+                                                Vec3{ 1, 1, 1 },
+                                                Vec3{ 1, 1, 1 }));
+
+  // two parallel mirrors on the left and right reflect the rays back and
+  // forth, so almost every path reaches the maximum recursion depth
+  const Material mirror(Vec3{ 0.05f, 0.05f, 0.05f },
+                        Vec3{ 0.1f, 0.1f, 0.1f },
+                        Vec3{ 1.0f, 1.0f, 1.0f }, 64, 0.05f);
+  s.addObject(std::make_shared<Plane>(Vec3{ 1.0f, 0.0f, 0.0f }, 2.0f, mirror));
+  s.addObject(std::make_shared<Plane>(Vec3{ -1.0f, 0.0f, 0.0f }, 2.0f, mirror));
+
+  const Material chrome(Vec3{ 0.1f, 0.1f, 0.1f },
+                        Vec3{ 0.3f, 0.3f, 0.3f },
+                        Vec3{ 1.0f, 1.0f, 1.0f }, 32, 0.1f);
+  for (int i = 0; i < 3; ++i)
+    s.addObject(std::make_shared<Sphere>(Vec3{ -1.0f + float(i), -0.5f, -2.0f - float(i) }, 0.45f, chrome));
+
+  const Material glass(Vec3{ 0.0f, 0.0f, 0.0f },
+                       Vec3{ 0.1f, 0.1f, 0.1f },
+                       Vec3{ 1.0f, 1.0f, 1.0f }, 64, 0.05f, 1.52f);
+  s.addObject(std::make_shared<Sphere>(Vec3{ 0.0f, 0.4f, -1.5f }, 0.35f, glass));
+
+  const Material floor(Vec3{ 0.3f, 0.3f, 0.3f },
+                       Vec3{ 0.5f, 0.5f, 0.5f },
+                       Vec3{ 1.0f, 1.0f, 1.0f }, 32, 0.5f);
+  s.addObject(std::make_shared<Plane>(Vec3{ 0.0f, 1.0f, 0.0f }, 1.5f, floor));
+  return s;
+}
+
+Scene Scene::genMeshScene(const std::string& filename) {
+  Scene s;
+  s.addLight(std::make_shared<const PointLight>(Vec3{ 0, 4, -2 },
+                                                Vec3{ 1, 1, 1 },
+                                                Vec3{ 1, 1, 1 },
+                                                Vec3{ 1, 1, 1 }));
+
+  // the OBJ file is normalized to a unit cube around the origin, move it
+  // onto the ground plane in front of the camera
+  OBJFile obj(filename, true);
+  for (Vec3& v : obj.vertices)
+    v = v * 2.0f + Vec3{ 0.0f, -0.5f, -2.0f };
+
+  const Material m(Vec3{ 0.3f, 0.2f, 0.1f },
+                   Vec3{ 0.7f, 0.5f, 0.3f },
+                   Vec3{ 1.0f, 1.0f, 1.0f }, 16, 1);
+  s.addObject(std::make_shared<TriangleMesh>(obj, m));
+
+  const Material floor(Vec3{ 0.3f, 0.3f, 0.3f },
+                       Vec3{ 0.5f, 0.5f, 0.5f },
+                       Vec3{ 1.0f, 1.0f, 1.0f }, 32, 0.5f);
+  s.addObject(std::make_shared<Plane>(Vec3{ 0.0f, 1.0f, 0.0f }, 1.5f, floor));
+  return s;
+}
+
+Scene Scene::genInstancedScene(uint32_t count, uint32_t seed) {
+  Scene s;
+  s.addLight(std::make_shared<const PointLight>(Vec3{ 0, 4, -2 },
+                                                Vec3{ 1, 1, 1 },
+                                                Vec3{ 1, 1, 1 },
+                                                Vec3{ 1, 1, 1 }));
+
+  // a ring of small spheres around a bigger one, built once and shared by all instances
+  const Material m(Vec3{ 0.2f, 0.2f, 0.2f },
+                   Vec3{ 0.6f, 0.6f, 0.6f },
+                   Vec3{ 1.0f, 1.0f, 1.0f }, 16, 1);
+  std::vector<std::shared_ptr<const IntersectableObject>> cluster;
+  cluster.push_back(std::make_shared<Sphere>(Vec3{ 0.0f, 0.0f, 0.0f }, 0.5f, m));
+  for (int i = 0; i < 12; ++i) {
+    const float angle = float(i) * 2.0f * 3.14159265f / 12.0f;
+    cluster.push_back(std::make_shared<Sphere>(Vec3{ 0.8f * std::cos(angle), 0.0f, 0.8f * std::sin(angle) }, 0.15f, m));
+  }
+  const auto group = std::make_shared<const ObjectGroup>(cluster, m);
+
+  Random rnd(seed);
+  for (uint32_t i = 0; i < count; ++i) {
+    const Mat4 transform = Mat4::translation(rnd.rand11() * 4.0f, rnd.rand11() * 2.0f, -3.0f - rnd.rand01() * 8.0f) *
+                           Mat4::rotationAxis(Vec3::normalize(Vec3{ rnd.rand11(), rnd.rand11(), rnd.rand11() }), rnd.rand01() * 360.0f) *
+                           Mat4::scaling(0.1f + rnd.rand01() * 0.3f);
+    const Material color(Vec3{ rnd.rand01(), rnd.rand01(), rnd.rand01() } * 0.3f,
+                         Vec3{ rnd.rand01(), rnd.rand01(), rnd.rand01() },
+                         Vec3{ 1.0f, 1.0f, 1.0f }, 16, 1);
+    s.addObject(std::make_shared<Instance>(group, transform, color));
+  }
+
+  const Material floor(Vec3{ 0.3f, 0.3f, 0.3f },
+                       Vec3{ 0.5f, 0.5f, 0.5f },
+                       Vec3{ 1.0f, 1.0f, 1.0f }, 32, 0.5f);
+  s.addObject(std::make_shared<Plane>(Vec3{ 0.0f, 1.0f, 0.0f }, 1.5f, floor));
+  return s;
+}
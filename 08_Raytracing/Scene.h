@@ -1,34 +1,177 @@
 #pragma once
 #include <memory>
+#include <string>
 #include <Vec3.h>
 #include <vector>
+#include "BVH.h"
+#include "CompiledScene.h"
 #include "IntersectableObject.h"
 #include "LightSource.h"
+#include "LightTree.h"
+#include "PacketKernels.h"
+#include "RayPacket.h"
+#include "SampleRandom.h"
+
+/// <summary>
+/// LINEAR tests every object for every ray and serves as the reference for
+/// correctness tests, BVH traverses the bounding volume hierarchy built by
+/// Scene::buildAccelerationStructure.
+/// </summary>
+enum class IntersectionMode {
+	LINEAR, BVH
+};
+
+/// <summary>
+/// Many-lights mode. Instead of one shadow ray per light, every shading
+/// point casts shadowRays shadow rays to point lights picked from the
+/// LightTree and divides their contributions by the probability of the pick.
+/// The ambient terms are summed exactly, lights other than point lights are
+/// always evaluated one by one.
+/// </summary>
+struct LightSampling
+{
+	bool enabled = false;
+	uint32_t shadowRays = 4;
+};
 
 class Scene
 {
 private:
-
 	static constexpr float OFFSET_EPSILON = 0.00001f;
 	std::vector<std::shared_ptr<const IntersectableObject>> sceneObjects;
+	std::vector<uint32_t> objectMaterials;	// material ID of every scene object
+	std::vector<Material> materials;
+	std::vector<bool> shadowCasters;
 	std::vector<std::shared_ptr<const LightSource>> lightSources;
 	Vec3 backgroundColor;
 
+	LightSampling lightSampling;
+	LightTree lightTree;
+	std::vector<uint32_t> treeLights;		// maps the lights of lightTree to lightSources
+	std::vector<uint32_t> otherLights;		// lights that are not in the tree
+	Vec3 treeAmbient;						// summed ambient color of the lights in the tree
+
+	IntersectionMode intersectionMode;
+	std::shared_ptr<const BVH> bvh;
+	std::shared_ptr<const BVH> prebuiltBVH;	// used instead of building bvh, see setPrebuiltHierarchy
+	std::vector<uint32_t> boundedObjects;	// maps BVH primitives to sceneObjects
+	std::vector<uint32_t> unboundedObjects;
+	CompiledScene compiled;	// flat copy of sceneObjects, built together with bvh
+	const PacketKernels* kernels;
+
 public:
 	Scene()
 		: Scene(Vec3{0.2f, 0.2f, 0.2f})
 	{}
 
 	Scene(const Vec3& backgroundColor)
-		: backgroundColor(backgroundColor)
+		: backgroundColor(backgroundColor), intersectionMode(IntersectionMode::BVH), kernels(&getPacketKernels())
 	{ }
 
 	void addObject(std::shared_ptr<const IntersectableObject> object);
 	void addLight(std::shared_ptr<const LightSource> ls);
 	Vec3 getBackgroundcolor() const;
+	const std::vector<std::shared_ptr<const IntersectableObject>>& getObjects() const;
+	const std::vector<std::shared_ptr<const LightSource>>& getLights() const;
+
+	/// <summary>
+	/// Material table, addObject appends the material of every object and
+	/// intersections refer to it by index.
+	/// </summary>
+	const Material& getMaterial(uint32_t materialID) const;
+	size_t getMaterialCount() const;
+
+	/// <summary>
+	/// Compiles the objects into flat arrays and builds the hierarchy over all
+	/// bounded objects, has to be called again after objects were added. Until
+	/// then intersect tests every object through its virtual methods. The
+	/// light tree of the many-lights mode is built here as well.
+	/// </summary>
+	void buildAccelerationStructure();
+	void setIntersectionMode(IntersectionMode mode);
+	IntersectionMode getIntersectionMode() const;
+	BVHBuildStats getBuildStats() const;
+
+	/// <summary>
+	/// Hierarchy over the bounded objects (in the order they were added) that
+	/// buildAccelerationStructure uses instead of building a new one, e.g. one
+	/// read from a scene file. Adding an object discards it.
+	/// getHierarchy returns the hierarchy in use, nullptr before it is built.
+	/// </summary>
+	void setPrebuiltHierarchy(std::shared_ptr<const BVH> hierarchy);
+	std::shared_ptr<const BVH> getHierarchy() const;
+
 	std::optional<Intersection> intersect(const Ray& ray, bool shadowRay) const;
-	Vec3 traceRay(const Ray& ray, float IOR, int recDepth) const;
+	std::optional<Intersection> intersect(const Ray& ray, bool shadowRay, BVHTraversalStats* stats) const;
+
+	/// <summary>
+	/// Returns true if any shadow casting object is hit by the ray at a distance of at most maxT.
+	/// Stops at the first such hit instead of searching for the closest one.
+	/// </summary>
+	bool occluded(const Ray& ray, float maxT) const;
+
+	/// <summary>
+	/// Light sampling draws its numbers from random, without a stream traceRay
+	/// and tracePacket evaluate every light even if light sampling is enabled.
+	/// </summary>
+	Vec3 traceRay(const Ray& ray, float IOR, int recDepth, SampleRandom* random = nullptr) const;
+
+	void setLightSampling(const LightSampling& lightSampling);
+	const LightSampling& getLightSampling() const;
+	size_t getLightCount() const;
+
+	/// <summary>
+	/// Selects the instruction set of the packet kernels, levels the CPU does
+	/// not support fall back to the next lower one.
+	/// </summary>
+	void setSIMDLevel(SIMDLevel level);
+
+	/// <summary>
+	/// Packet versions of intersect, occluded and traceRay. They compute
+	/// exactly the same values as the scalar methods for every active lane.
+	/// occludedPacket returns the lanes that are in shadow, tracePacket
+	/// writes one color per active lane. Inactive lanes of the packet must
+	/// hold valid rays, see RayPacket::fillInactive. randoms holds one stream
+	/// per lane for light sampling.
+	/// </summary>
+	void intersectPacket(const RayPacket& packet, PacketHit& hit) const;
+	uint32_t occludedPacket(const RayPacket& packet, const float* maxT) const;
+	void tracePacket(const RayPacket& packet, float IOR, int recDepth, Vec3* colors, SampleRandom* randoms = nullptr) const;
 
 	static Scene genSimpleScene();
 
+	/// <summary>
+	/// Stress scenes for benchmarks, all are seen from the camera of the
+	/// simple scene. genRandomSpheres adds count random spheres to the simple
+	/// scene, genManyLights lights it with count point lights and
+	/// genDeepReflection places mirrored spheres between two parallel mirrors.
+	/// </summary>
+	static Scene genRandomSpheres(uint32_t count, uint32_t seed = 42);
+	static Scene genManyLights(uint32_t count, uint32_t seed = 42);
+	static Scene genDeepReflection();
+
+	/// <summary>
+	/// The ground plane and light of the simple scene with the mesh of the
+	/// OBJ file scaled to a unit cube in front of the camera.
+	/// </summary>
+	static Scene genMeshScene(const std::string& filename);
+
+	/// <summary>
+	/// count randomly rotated and scaled instances of one cluster of spheres,
+	/// the spheres of the cluster exist only once in memory.
+	/// </summary>
+	static Scene genInstancedScene(uint32_t count, uint32_t seed = 42);
+
+private:
+	std::optional<Intersection> intersectLinear(const Ray& ray, bool shadowRay) const;
+	std::optional<Intersection> intersectBVH(const Ray& ray, bool shadowRay, BVHTraversalStats* stats) const;
+	void intersectPacketObject(uint32_t index, const RayPacket& packet, uint32_t mask, PacketHit& hit) const;
+	uint32_t hitsPacketObject(uint32_t index, const RayPacket& packet, uint32_t mask, const float* maxT) const;
+	void buildLightTree();
+	bool samplesLights() const;
+	Vec3 shadeLight(const Vec3& localColor, const Ray& ray, const Intersection& inter,
+	                const Vec3& lightDir, const LightSource& ls, bool inShadow) const;
+	void directLight(const Ray& ray, const Intersection& inter, const Vec3& lightDir, const LightSource& ls,
+	                 Vec3& diffuse, Vec3& specular) const;
+
 };
@@ -0,0 +1,602 @@
+#include "SceneFile.h"
+#include "MappedFile.h"
+#include "Plane.h"
+#include "PointLight.h"
+#include "Sphere.h"
+#include "TriangleMesh.h"
+
+#include <OBJFile.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <utility>
+
+namespace {
+	constexpr char MAGIC[8] = { 'R', 'T', 'S', 'C', 'E', 'N', 'E', '\0' };
+	constexpr uint32_t VERSION = 1;
+	constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+	constexpr size_t SECTION_ALIGNMENT = 64;
+
+	enum Section : uint32_t {
+		MATERIALS, LIGHTS, OBJECTS, SPHERES, PLANES, MESHES,
+		TRIANGLES, VERTEX_INDICES, NORMALS, MESH_NODES, MESH_PRIMITIVES,
+		SCENE_NODES, SCENE_PRIMITIVES, SECTION_COUNT
+	};
+
+	struct SectionRecord
+	{
+		uint64_t offset;
+		uint64_t count;
+	};
+
+	struct StatsRecord
+	{
+		uint64_t primitiveCount;
+		uint64_t nodeCount;
+		uint64_t leafCount;
+		uint32_t maxDepth;
+		uint32_t maxLeafSize;
+		float sahCost;
+		uint32_t reserved;
+	};
+
+	struct HeaderRecord
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrder;
+		float background[3];
+		uint32_t reserved;
+		StatsRecord sceneStats;
+		SectionRecord sections[SECTION_COUNT];
+	};
+
+	constexpr uint32_t HAS_IOR = 1;
+	constexpr uint32_t SHADOW_CASTER = 2;
+
+	struct MaterialRecord
+	{
+		float ambient[3];
+		float diffuse[3];
+		float specular[3];
+		float exponent;
+		float local;
+		float IOR;
+		uint32_t flags;
+	};
+
+	struct LightRecord
+	{
+		float position[3];
+		float ambient[3];
+		float diffuse[3];
+		float specular[3];
+	};
+
+	enum ObjectKind : uint32_t {
+		SPHERE, PLANE, MESH
+	};
+
+	struct ObjectRecord
+	{
+		uint32_t kind;
+		uint32_t material;
+		uint32_t index;		// into the spheres, planes or meshes
+	};
+
+	struct SphereRecord
+	{
+		float center[3];
+		float radius;
+	};
+
+	struct PlaneRecord
+	{
+		float normal[3];
+		float d;
+	};
+
+	// ranges of the mesh in the TRIANGLES (and VERTEX_INDICES), NORMALS,
+	// MESH_NODES and MESH_PRIMITIVES sections
+	struct MeshRecord
+	{
+		uint64_t firstTriangle;
+		uint64_t triangleCount;
+		uint64_t firstNormal;
+		uint64_t normalCount;
+		uint64_t firstNode;
+		uint64_t nodeCount;
+		uint64_t firstPrimitive;
+		uint64_t primitiveCount;
+		StatsRecord stats;
+	};
+
+	// triangles, vertex indices, normals and nodes are stored exactly as they are kept in memory
+	using VertexIndices = std::array<uint32_t, 3>;
+	static_assert(sizeof(Vec3) == 3 * sizeof(float), "Vec3 has to consist of three packed floats");
+	static_assert(sizeof(TriangleMesh::Triangle) == 3 * sizeof(Vec3), "Triangle has to consist of three packed Vec3");
+	static_assert(sizeof(VertexIndices) == 3 * sizeof(uint32_t), "vertex indices have to be packed");
+	static_assert(sizeof(BVHNode) == 2 * sizeof(Vec3) + 8, "BVHNode has to be packed");
+
+	constexpr size_t SECTION_RECORD_SIZES[SECTION_COUNT] = {
+		sizeof(MaterialRecord), sizeof(LightRecord), sizeof(ObjectRecord), sizeof(SphereRecord),
+		sizeof(PlaneRecord), sizeof(MeshRecord), sizeof(TriangleMesh::Triangle), sizeof(VertexIndices),
+		sizeof(Vec3), sizeof(BVHNode), sizeof(uint32_t), sizeof(BVHNode), sizeof(uint32_t)
+	};
+
+	void toFloats(const Vec3& v, float* f)
+	{
+		f[0] = v.x;
+		f[1] = v.y;
+		f[2] = v.z;
+	}
+
+	Vec3 toVec3(const float* f)
+	{
+		return Vec3{ f[0], f[1], f[2] };
+	}
+
+	StatsRecord toRecord(const BVHBuildStats& stats)
+	{
+		return StatsRecord{ stats.primitiveCount, stats.nodeCount, stats.leafCount,
+		                    stats.maxDepth, stats.maxLeafSize, stats.sahCost, 0 };
+	}
+
+	BVHBuildStats fromRecord(const StatsRecord& record)
+	{
+		BVHBuildStats stats;
+		stats.primitiveCount = size_t(record.primitiveCount);
+		stats.nodeCount = size_t(record.nodeCount);
+		stats.leafCount = size_t(record.leafCount);
+		stats.maxDepth = record.maxDepth;
+		stats.maxLeafSize = record.maxLeafSize;
+		stats.sahCost = record.sahCost;
+		return stats;
+	}
+
+	MaterialRecord toRecord(const Material& material)
+	{
+		MaterialRecord record{};
+		toFloats(material.getAmbient(), record.ambient);
+		toFloats(material.getDiffuse(), record.diffuse);
+		toFloats(material.getSpecular(), record.specular);
+		record.exponent = material.getExp();
+		record.local = material.getLocalRefectivity();
+		record.IOR = material.getIndexOfRefraction().value_or(1.0f);
+		record.flags = (material.refracts() ? HAS_IOR : 0) | (material.isShadowCaster() ? SHADOW_CASTER : 0);
+		return record;
+	}
+
+	Material fromRecord(const MaterialRecord& record)
+	{
+		std::optional<float> IOR;
+		if (record.flags & HAS_IOR)
+			IOR = record.IOR;
+		return Material(toVec3(record.ambient), toVec3(record.diffuse), toVec3(record.specular),
+		                record.exponent, record.local, IOR, (record.flags & SHADOW_CASTER) != 0);
+	}
+
+	// appends count values as the next section, aligned to SECTION_ALIGNMENT
+	template <typename T>
+	void appendSection(std::vector<uint8_t>& file, HeaderRecord& header, Section section, const T* values, size_t count)
+	{
+		file.resize((file.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT, 0);
+		header.sections[section] = SectionRecord{ file.size(), count };
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(values);
+		file.insert(file.end(), bytes, bytes + count * sizeof(T));
+	}
+
+	// the sections are aligned, so the arrays can be read and copied in bulk
+	// right where they are mapped
+	template <typename T>
+	const T* sectionData(const MappedFile& file, const HeaderRecord& header, Section section)
+	{
+		return reinterpret_cast<const T*>(file.getData() + header.sections[section].offset);
+	}
+
+	bool fail(const std::string& filename, const std::string& message)
+	{
+		std::cerr << filename << ": " << message << std::endl;
+		return false;
+	}
+}
+
+bool SceneFile::isBinary(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	char magic[sizeof(MAGIC)] = {};
+	file.read(magic, sizeof(magic));
+	return file && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool SceneFile::load(const std::string& filename, Scene& scene)
+{
+	return isBinary(filename) ? loadBinary(filename, scene) : loadText(filename, scene);
+}
+
+bool SceneFile::loadText(const std::string& filename, Scene& scene)
+{
+	std::ifstream file(filename);
+	if (!file)
+		return fail(filename, "could not open the file");
+
+	Vec3 background{ 0.2f, 0.2f, 0.2f };
+	std::map<std::string, Material> materials;
+	std::vector<std::shared_ptr<const IntersectableObject>> objects;
+	std::vector<std::shared_ptr<const LightSource>> lights;
+	const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+
+	std::string line;
+	for (uint32_t lineNumber = 1; std::getline(file, line); ++lineNumber)
+	{
+		const std::string where = "line " + std::to_string(lineNumber) + ": ";
+		std::istringstream tokens(line.substr(0, line.find('#')));
+		std::string keyword;
+		if (!(tokens >> keyword))
+			continue;
+
+		auto readVec3 = [&](Vec3& v) { return bool(tokens >> v.x >> v.y >> v.z); };
+		auto readMaterial = [&]() -> const Material* {
+			std::string name;
+			if (!(tokens >> name))
+				return nullptr;
+			const auto it = materials.find(name);
+			if (it == materials.end())
+				throw std::invalid_argument("unknown material " + name);
+			return &it->second;
+		};
+
+		try
+		{
+			bool valid = true;
+			if (keyword == "background")
+			{
+				valid = readVec3(background);
+			}
+			else if (keyword == "light")
+			{
+				Vec3 position, ambient, diffuse, specular;
+				valid = readVec3(position) && readVec3(ambient) && readVec3(diffuse) && readVec3(specular);
+				if (valid)
+					lights.push_back(std::make_shared<const PointLight>(position, ambient, diffuse, specular));
+			}
+			else if (keyword == "material")
+			{
+				std::string name;
+				Vec3 ambient, diffuse, specular;
+				float exponent, local;
+				valid = (tokens >> name) && readVec3(ambient) && readVec3(diffuse) && readVec3(specular) &&
+				        (tokens >> exponent >> local);
+				std::optional<float> IOR;
+				bool shadowCaster = true;
+				std::string option;
+				while (valid && tokens >> option)
+				{
+					if (option == "ior")
+					{
+						float value;
+						valid = bool(tokens >> value);
+						IOR = value;
+					}
+					else if (option == "noshadow")
+						shadowCaster = false;
+					else
+						throw std::invalid_argument("unknown material option " + option);
+				}
+				if (valid)
+					materials.insert_or_assign(name, Material(ambient, diffuse, specular, exponent, local, IOR, shadowCaster));
+			}
+			else if (keyword == "sphere")
+			{
+				Vec3 center;
+				float radius;
+				const Material* material = nullptr;
+				valid = readVec3(center) && (tokens >> radius) && (material = readMaterial());
+				if (valid)
+					objects.push_back(std::make_shared<Sphere>(center, radius, *material));
+			}
+			else if (keyword == "plane")
+			{
+				Vec3 normal;
+				float d;
+				const Material* material = nullptr;
+				valid = readVec3(normal) && (tokens >> d) && (material = readMaterial());
+				if (valid)
+					objects.push_back(std::make_shared<Plane>(Vec3::normalize(normal), d, *material));
+			}
+			else if (keyword == "mesh")
+			{
+				std::string meshFile;
+				const Material* material = nullptr;
+				valid = (tokens >> meshFile) && (material = readMaterial());
+
+				float scale = 1.0f;
+				Vec3 translation{ 0.0f, 0.0f, 0.0f };
+				std::string option;
+				while (valid && tokens >> option)
+				{
+					if (option == "scale")
+						valid = bool(tokens >> scale);
+					else if (option == "translate")
+						valid = readVec3(translation);
+					else
+						throw std::invalid_argument("unknown mesh option " + option);
+				}
+
+				if (valid)
+				{
+					std::filesystem::path path(meshFile);
+					if (path.is_relative())
+						path = directory / path;
+					if (!std::ifstream(path.string()))
+						throw std::invalid_argument("could not open " + path.string());
+
+					OBJFile obj(path.string(), true);
+					for (Vec3& v : obj.vertices)
+						v = v * scale + translation;
+					objects.push_back(std::make_shared<TriangleMesh>(obj, *material));
+				}
+			}
+			else
+			{
+				throw std::invalid_argument("unknown statement " + keyword);
+			}
+
+			if (!valid)
+				throw std::invalid_argument("missing or invalid values in " + keyword);
+		}
+		catch (const std::exception& e)
+		{
+			return fail(filename, where + e.what());
+		}
+	}
+
+	scene = Scene(background);
+	for (const auto& light : lights)
+		scene.addLight(light);
+	for (const auto& object : objects)
+		scene.addObject(object);
+	return true;
+}
+
+bool SceneFile::saveBinary(const Scene& scene, const std::string& filename)
+{
+	Scene built = scene;
+	if (!built.getHierarchy())
+		built.buildAccelerationStructure();
+
+	HeaderRecord header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.byteOrder = BYTE_ORDER_MARK;
+	toFloats(built.getBackgroundcolor(), header.background);
+
+	std::vector<MaterialRecord> materials;
+	std::vector<ObjectRecord> objects;
+	std::vector<SphereRecord> spheres;
+	std::vector<PlaneRecord> planes;
+	std::vector<MeshRecord> meshes;
+	std::vector<TriangleMesh::Triangle> triangles;
+	std::vector<VertexIndices> vertexIndices;
+	std::vector<Vec3> normals;
+	std::vector<BVHNode> meshNodes;
+	std::vector<uint32_t> meshPrimitives;
+
+	const auto& sceneObjects = built.getObjects();
+	for (uint32_t i = 0; i < uint32_t(sceneObjects.size()); ++i)
+	{
+		// objects with the same material share one record
+		const MaterialRecord material = toRecord(sceneObjects[i]->getMaterial());
+		uint32_t materialIndex = 0;
+		while (materialIndex < materials.size() && std::memcmp(&materials[materialIndex], &material, sizeof(material)) != 0)
+			++materialIndex;
+		if (materialIndex == materials.size())
+			materials.push_back(material);
+
+		const IntersectableObject* object = sceneObjects[i].get();
+		if (const Sphere* sphere = dynamic_cast<const Sphere*>(object))
+		{
+			SphereRecord record;
+			toFloats(sphere->getCenter(), record.center);
+			record.radius = sphere->getRadius();
+			objects.push_back(ObjectRecord{ SPHERE, materialIndex, uint32_t(spheres.size()) });
+			spheres.push_back(record);
+		}
+		else if (const Plane* plane = dynamic_cast<const Plane*>(object))
+		{
+			PlaneRecord record;
+			toFloats(plane->getNormal(), record.normal);
+			record.d = plane->getD();
+			objects.push_back(ObjectRecord{ PLANE, materialIndex, uint32_t(planes.size()) });
+			planes.push_back(record);
+		}
+		else if (const TriangleMesh* mesh = dynamic_cast<const TriangleMesh*>(object))
+		{
+			const BVH& bvh = mesh->getBVH();
+			meshes.push_back(MeshRecord{ triangles.size(), mesh->getTriangles().size(),
+			                             normals.size(), mesh->getNormals().size(),
+			                             meshNodes.size(), bvh.getNodes().size(),
+			                             meshPrimitives.size(), bvh.getPrimitiveIndices().size(),
+			                             toRecord(bvh.getBuildStats()) });
+			objects.push_back(ObjectRecord{ MESH, materialIndex, uint32_t(meshes.size() - 1) });
+			triangles.insert(triangles.end(), mesh->getTriangles().begin(), mesh->getTriangles().end());
+			vertexIndices.insert(vertexIndices.end(), mesh->getIndices().begin(), mesh->getIndices().end());
+			normals.insert(normals.end(), mesh->getNormals().begin(), mesh->getNormals().end());
+			meshNodes.insert(meshNodes.end(), bvh.getNodes().begin(), bvh.getNodes().end());
+			meshPrimitives.insert(meshPrimitives.end(), bvh.getPrimitiveIndices().begin(), bvh.getPrimitiveIndices().end());
+		}
+		else
+		{
+			return fail(filename, "object " + std::to_string(i) + " is neither a sphere, a plane nor a triangle mesh");
+		}
+	}
+
+	std::vector<LightRecord> lights;
+	for (const auto& light : built.getLights())
+	{
+		const PointLight* pointLight = dynamic_cast<const PointLight*>(light.get());
+		if (!pointLight)
+			return fail(filename, "only point lights can be stored");
+		LightRecord record;
+		toFloats(pointLight->getPosition(), record.position);
+		toFloats(pointLight->getAmbient(), record.ambient);
+		toFloats(pointLight->getDiffuse(), record.diffuse);
+		toFloats(pointLight->getSpecular(), record.specular);
+		lights.push_back(record);
+	}
+
+	const BVH& sceneBVH = *built.getHierarchy();
+	header.sceneStats = toRecord(sceneBVH.getBuildStats());
+
+	std::vector<uint8_t> file(sizeof(HeaderRecord));
+	appendSection(file, header, MATERIALS, materials.data(), materials.size());
+	appendSection(file, header, LIGHTS, lights.data(), lights.size());
+	appendSection(file, header, OBJECTS, objects.data(), objects.size());
+	appendSection(file, header, SPHERES, spheres.data(), spheres.size());
+	appendSection(file, header, PLANES, planes.data(), planes.size());
+	appendSection(file, header, MESHES, meshes.data(), meshes.size());
+	appendSection(file, header, TRIANGLES, triangles.data(), triangles.size());
+	appendSection(file, header, VERTEX_INDICES, vertexIndices.data(), vertexIndices.size());
+	appendSection(file, header, NORMALS, normals.data(), normals.size());
+	appendSection(file, header, MESH_NODES, meshNodes.data(), meshNodes.size());
+	appendSection(file, header, MESH_PRIMITIVES, meshPrimitives.data(), meshPrimitives.size());
+	appendSection(file, header, SCENE_NODES, sceneBVH.getNodes().data(), sceneBVH.getNodes().size());
+	appendSection(file, header, SCENE_PRIMITIVES, sceneBVH.getPrimitiveIndices().data(), sceneBVH.getPrimitiveIndices().size());
+	std::memcpy(file.data(), &header, sizeof(header));
+
+	std::ofstream output(filename, std::ios::binary);
+	output.write(reinterpret_cast<const char*>(file.data()), std::streamsize(file.size()));
+	if (!output)
+		return fail(filename, "could not write the file");
+	return true;
+}
+
+bool SceneFile::loadBinary(const std::string& filename, Scene& scene)
+{
+	const MappedFile file(filename);
+	if (!file.isOpen())
+		return fail(filename, "could not open the file");
+
+	HeaderRecord header;
+	if (file.getSize() < sizeof(header))
+		return fail(filename, "not a binary scene file");
+	std::memcpy(&header, file.getData(), sizeof(header));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+		return fail(filename, "not a binary scene file");
+	if (header.version != VERSION)
+		return fail(filename, "unsupported version " + std::to_string(header.version));
+	if (header.byteOrder != BYTE_ORDER_MARK)
+		return fail(filename, "written on a machine with a different byte order");
+
+	for (uint32_t s = 0; s < SECTION_COUNT; ++s)
+	{
+		const SectionRecord& section = header.sections[s];
+		if (section.offset % SECTION_ALIGNMENT != 0 || section.offset > file.getSize() ||
+		    section.count > (file.getSize() - section.offset) / SECTION_RECORD_SIZES[s])
+			return fail(filename, "section " + std::to_string(s) + " lies outside of the file");
+	}
+
+	auto count = [&](Section section) { return header.sections[section].count; };
+	auto inRange = [&](Section section, uint64_t first, uint64_t length) {
+		return first <= count(section) && length <= count(section) - first;
+	};
+
+	const MaterialRecord* materials = sectionData<MaterialRecord>(file, header, MATERIALS);
+	const LightRecord* lights = sectionData<LightRecord>(file, header, LIGHTS);
+	const ObjectRecord* objects = sectionData<ObjectRecord>(file, header, OBJECTS);
+	const SphereRecord* spheres = sectionData<SphereRecord>(file, header, SPHERES);
+	const PlaneRecord* planes = sectionData<PlaneRecord>(file, header, PLANES);
+	const MeshRecord* meshes = sectionData<MeshRecord>(file, header, MESHES);
+	const TriangleMesh::Triangle* triangles = sectionData<TriangleMesh::Triangle>(file, header, TRIANGLES);
+	const VertexIndices* vertexIndices = sectionData<VertexIndices>(file, header, VERTEX_INDICES);
+	const Vec3* normals = sectionData<Vec3>(file, header, NORMALS);
+	const BVHNode* meshNodes = sectionData<BVHNode>(file, header, MESH_NODES);
+	const uint32_t* meshPrimitives = sectionData<uint32_t>(file, header, MESH_PRIMITIVES);
+	const BVHNode* sceneNodes = sectionData<BVHNode>(file, header, SCENE_NODES);
+	const uint32_t* scenePrimitives = sectionData<uint32_t>(file, header, SCENE_PRIMITIVES);
+
+	if (count(TRIANGLES) != count(VERTEX_INDICES))
+		return fail(filename, "every triangle needs its vertex indices");
+
+	// the caller's scene is only replaced once the whole file was read
+	Scene loaded(toVec3(header.background));
+	for (uint64_t i = 0; i < count(LIGHTS); ++i)
+		loaded.addLight(std::make_shared<const PointLight>(toVec3(lights[i].position), toVec3(lights[i].ambient),
+		                                                  toVec3(lights[i].diffuse), toVec3(lights[i].specular)));
+
+	for (uint64_t i = 0; i < count(OBJECTS); ++i)
+	{
+		const ObjectRecord& object = objects[i];
+		if (object.material >= count(MATERIALS))
+			return fail(filename, "object " + std::to_string(i) + " refers to a missing material");
+		const Material material = fromRecord(materials[object.material]);
+
+		if (object.kind == SPHERE && object.index < count(SPHERES))
+		{
+			const SphereRecord& sphere = spheres[object.index];
+			loaded.addObject(std::make_shared<Sphere>(toVec3(sphere.center), sphere.radius, material));
+		}
+		else if (object.kind == PLANE && object.index < count(PLANES))
+		{
+			const PlaneRecord& plane = planes[object.index];
+			loaded.addObject(std::make_shared<Plane>(toVec3(plane.normal), plane.d, material));
+		}
+		else if (object.kind == MESH && object.index < count(MESHES))
+		{
+			const MeshRecord& mesh = meshes[object.index];
+			if (!inRange(TRIANGLES, mesh.firstTriangle, mesh.triangleCount) ||
+			    !inRange(NORMALS, mesh.firstNormal, mesh.normalCount) ||
+			    !inRange(MESH_NODES, mesh.firstNode, mesh.nodeCount) ||
+			    !inRange(MESH_PRIMITIVES, mesh.firstPrimitive, mesh.primitiveCount))
+				return fail(filename, "mesh " + std::to_string(object.index) + " lies outside of its sections");
+
+			const auto* t = triangles + mesh.firstTriangle;
+			const auto* v = vertexIndices + mesh.firstTriangle;
+			const auto* n = normals + mesh.firstNormal;
+			const auto* b = meshNodes + mesh.firstNode;
+			const auto* p = meshPrimitives + mesh.firstPrimitive;
+			if (mesh.normalCount > 0)
+			{
+				for (uint64_t j = 0; j < mesh.triangleCount; ++j)
+					if (v[j][0] >= mesh.normalCount || v[j][1] >= mesh.normalCount || v[j][2] >= mesh.normalCount)
+						return fail(filename, "mesh " + std::to_string(object.index) + " refers to a missing normal");
+			}
+			BVH bvh({ b, b + mesh.nodeCount }, { p, p + mesh.primitiveCount }, fromRecord(mesh.stats));
+			if (!bvh.isValid(mesh.triangleCount))
+				return fail(filename, "mesh " + std::to_string(object.index) + " has an invalid hierarchy");
+			loaded.addObject(std::make_shared<TriangleMesh>(std::vector<TriangleMesh::Triangle>{ t, t + mesh.triangleCount },
+			                                               std::vector<VertexIndices>{ v, v + mesh.triangleCount },
+			                                               std::vector<Vec3>{ n, n + mesh.normalCount },
+			                                               std::move(bvh), material));
+		}
+		else
+		{
+			return fail(filename, "object " + std::to_string(i) + " has an invalid kind or index");
+		}
+	}
+
+	// has to come last, adding objects discards a prebuilt hierarchy
+	if (count(SCENE_NODES) > 0)
+	{
+		auto bvh = std::make_shared<const BVH>(
+			std::vector<BVHNode>{ sceneNodes, sceneNodes + count(SCENE_NODES) },
+			std::vector<uint32_t>{ scenePrimitives, scenePrimitives + count(SCENE_PRIMITIVES) },
+			fromRecord(header.sceneStats));
+
+		// the hierarchy of the scene is built over its bounded objects only
+		size_t boundedCount = 0;
+		for (const auto& object : loaded.getObjects())
+			if (object->getBounds().has_value())
+				++boundedCount;
+		if (!bvh->isValid(boundedCount))
+			return fail(filename, "the scene has an invalid hierarchy");
+		loaded.setPrebuiltHierarchy(bvh);
+	}
+
+	scene = std::move(loaded);
+	return true;
+}
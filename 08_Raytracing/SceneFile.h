@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+
+#include "Scene.h"
+
+/// <summary>
+/// Reads and writes scenes, so new scenes need no recompile.
+///
+/// The text format is meant for authoring. Every line holds one statement,
+/// everything after a # is a comment:
+///
+///   background R G B
+///   light X Y Z  AR AG AB  DR DG DB  SR SG SB        point light with ambient, diffuse and specular color
+///   material NAME  AR AG AB  DR DG DB  SR SG SB  EXPONENT LOCAL [ior IOR] [noshadow]
+///   sphere X Y Z RADIUS MATERIAL
+///   plane NX NY NZ D MATERIAL
+///   mesh FILE MATERIAL [scale S] [translate X Y Z]   OBJ file normalized to a unit cube, then scaled and moved
+///
+/// Materials have to be defined before they are used, relative mesh paths
+/// are relative to the scene file.
+///
+/// The binary format is a cache of a built scene: flat arrays of materials,
+/// lights, spheres, planes and mesh triangles together with the hierarchies
+/// of the scene and of every mesh, each at a 64 byte aligned offset given in
+/// the header. loadBinary maps the file into memory and copies the arrays in
+/// bulk into the objects, nothing is parsed and no hierarchy is built. The
+/// byte order is that of the machine that wrote the file. While copying, all
+/// indices are checked against the arrays they refer to, so a damaged file
+/// fails to load instead of crashing the renderer.
+///
+/// All methods print the reason of a failure to std::cerr and return false.
+/// </summary>
+class SceneFile
+{
+public:
+	/// <summary>
+	/// Loads a file in either format, binary files are recognized by their header.
+	/// </summary>
+	static bool load(const std::string& filename, Scene& scene);
+	static bool loadText(const std::string& filename, Scene& scene);
+	static bool loadBinary(const std::string& filename, Scene& scene);
+
+	/// <summary>
+	/// Builds the acceleration structures of the scene if necessary and writes
+	/// them along with the scene. Only spheres, planes, triangle meshes and
+	/// point lights can be stored.
+	/// </summary>
+	static bool saveBinary(const Scene& scene, const std::string& filename);
+
+	static bool isBinary(const std::string& filename);
+};
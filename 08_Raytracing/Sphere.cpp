@@ -1,7 +1,7 @@
 #include "Sphere.h"
 
 Sphere::Sphere(const Vec3& center, float radius, const Material& material)
-	: center(center), sqradius(radius* radius), material(material)
+	: center(center), radius(radius), sqradius(radius* radius), material(material)
 {
 
 }
@@ -32,5 +32,32 @@ std::optional<Intersection> Sphere::intersect(const Ray& ray) const
 	Vec3 normal = ray.getPosOnRay(t) - center;
 	normal = Vec3::normalize(normal);
 
-	return Intersection{ material, normal, t };
+	return Intersection{ normal, t };
+}
+
+std::optional<AABB> Sphere::getBounds() const
+{
+	return AABB{ center - radius, center + radius };
+}
+
+bool Sphere::hits(const Ray& ray, float tMax) const
+{
+	// same as intersect but without the normal and the Intersection object
+	Vec3 l = center - ray.getOrigin();
+
+	float tCenter = Vec3::dot(l, ray.getDirection());
+	if (tCenter < 0)
+		return false;
+
+	float dSq = l.sqlength() - tCenter * tCenter;
+	if (dSq > sqradius)
+		return false;
+
+	float dist = sqrt(sqradius - dSq);
+	float t = tCenter - dist;
+
+	if (t < 0)
+		t = tCenter + dist;	// when inside sphere
+
+	return t <= tMax;
 }
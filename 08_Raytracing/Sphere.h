@@ -5,6 +5,7 @@ class Sphere : public IntersectableObject
 {
 private:
 	const Vec3 center;
+	const float radius;
 	const float sqradius;
 	const Material material;
 
@@ -14,6 +15,12 @@ public:
 
 	Material getMaterial() const override;
 	std::optional<Intersection> intersect(const Ray& ray) const override;
+	bool hits(const Ray& ray, float tMax) const override;
+	std::optional<AABB> getBounds() const override;
+
+	Vec3 getCenter() const { return center; }
+	float getRadius() const { return radius; }
+	float getSqRadius() const { return sqradius; }
 
 };
 
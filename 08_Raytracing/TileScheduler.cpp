@@ -0,0 +1,71 @@
+#include "TileScheduler.h"
+#include <algorithm>
+
+TileScheduler::TileScheduler(uint32_t width, uint32_t height, uint32_t tileSize, uint32_t workerCount)
+	: queues(std::max(1u, workerCount)), tileCount(0)
+{
+	tileSize = std::max(1u, tileSize);
+
+	// deal the tiles out round robin so that every worker starts with a
+	// share of each region of the image
+	uint32_t index = 0;
+	for (uint32_t y = 0; y < height; y += tileSize)
+	{
+		for (uint32_t x = 0; x < width; x += tileSize)
+		{
+			const Tile tile{ x, y, std::min(x + tileSize, width), std::min(y + tileSize, height), index };
+			queues[index % queues.size()].tiles.push_back(tile);
+			++index;
+		}
+	}
+	tileCount = index;
+}
+
+std::optional<Tile> TileScheduler::next(uint32_t worker)
+{
+	std::optional<Tile> tile = popFront(worker);
+	if (tile.has_value())
+		return tile;
+
+	const uint32_t workerCount = uint32_t(queues.size());
+	for (uint32_t i = 1; i < workerCount; ++i)
+	{
+		tile = stealBack((worker + i) % workerCount);
+		if (tile.has_value())
+			return tile;
+	}
+	return {};
+}
+
+size_t TileScheduler::getTileCount() const
+{
+	return tileCount;
+}
+
+std::optional<Tile> TileScheduler::popFront(uint32_t worker)
+{
+	WorkQueue& queue = queues[worker];
+	std::scoped_lock lock(queue.mutex);
+	if (queue.tiles.empty())
+		return {};
+	const Tile tile = queue.tiles.front();
+	queue.tiles.pop_front();
+	return tile;
+}
+
+std::optional<Tile> TileScheduler::stealBack(uint32_t victim)
+{
+	WorkQueue& queue = queues[victim];
+	std::scoped_lock lock(queue.mutex);
+	if (queue.tiles.empty())
+		return {};
+	const Tile tile = queue.tiles.back();
+	queue.tiles.pop_back();
+	return tile;
+}
+
+size_t TileScheduler::getTileCount(uint32_t width, uint32_t height, uint32_t tileSize)
+{
+	tileSize = std::max(1u, tileSize);
+	return size_t((width + tileSize - 1) / tileSize) * size_t((height + tileSize - 1) / tileSize);
+}
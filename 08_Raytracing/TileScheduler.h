@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/// <summary>
+/// A rectangular block of pixels [x0, x1) x [y0, y1) of the output image.
+/// </summary>
+struct Tile
+{
+	uint32_t x0;
+	uint32_t y0;
+	uint32_t x1;
+	uint32_t y1;
+	uint32_t index;
+};
+
+/// <summary>
+/// Splits an image into tiles and hands them out to a fixed number of workers.
+/// Every worker owns a deque of tiles and takes work from its front. Once a
+/// worker runs dry it steals from the back of the other workers' deques, so
+/// expensive regions of the image do not leave the remaining threads idle.
+/// </summary>
+class TileScheduler
+{
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Tile> tiles;
+	};
+
+	std::vector<WorkQueue> queues;
+	size_t tileCount;
+
+public:
+	TileScheduler(uint32_t width, uint32_t height, uint32_t tileSize, uint32_t workerCount);
+
+	/// <summary>
+	/// Returns the next tile for the given worker or nothing if all tiles have been handed out.
+	/// </summary>
+	std::optional<Tile> next(uint32_t worker);
+	size_t getTileCount() const;
+	static size_t getTileCount(uint32_t width, uint32_t height, uint32_t tileSize);
+
+private:
+	std::optional<Tile> popFront(uint32_t worker);
+	std::optional<Tile> stealBack(uint32_t victim);
+};
@@ -0,0 +1,52 @@
+#include "ToneMapper.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float encodeSRGB(float value)
+{
+    if (value <= 0.0031308f)
+        return 12.92f * value;
+    return 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+}
+
+Vec3 ToneMapper::map(const Vec3& color) const
+{
+    Vec3 mapped = color;
+    if (exposure != 0.0f)
+        mapped = mapped * std::exp2(exposure);
+
+    if (op == ToneMappingOperator::REINHARD)
+        mapped = Vec3{ mapped.r / (1.0f + mapped.r), mapped.g / (1.0f + mapped.g), mapped.b / (1.0f + mapped.b) };
+
+    mapped = Vec3{ std::clamp(mapped.r, 0.0f, 1.0f), std::clamp(mapped.g, 0.0f, 1.0f), std::clamp(mapped.b, 0.0f, 1.0f) };
+
+    if (sRGB)
+        mapped = Vec3{ encodeSRGB(mapped.r), encodeSRGB(mapped.g), encodeSRGB(mapped.b) };
+    return mapped;
+}
+
+void ToneMapper::apply(const FilmBuffer& film, Image& img) const
+{
+    if (img.width != film.getWidth() || img.height != film.getHeight() || img.componentCount != 4)
+        img = Image(film.getWidth(), film.getHeight(), 4);
+    apply(film, img, Tile{ 0, 0, film.getWidth(), film.getHeight(), 0 });
+}
+
+void ToneMapper::apply(const FilmBuffer& film, Image& img, const Tile& tile) const
+{
+    for (uint32_t y = tile.y0; y < tile.y1; ++y)
+    {
+        for (uint32_t x = tile.x0; x < tile.x1; ++x)
+        {
+            const Vec3 color = map(film.getColor(x, y));
+            img.setNormalizedValue(x, y, 0, color.r);
+            img.setNormalizedValue(x, y, 1, color.g);
+            img.setNormalizedValue(x, y, 2, color.b);
+            img.setValue(x, y, 3, 255);
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <Vec3.h>
+#include <Image.h>
+
+#include "FilmBuffer.h"
+#include "TileScheduler.h"
+
+enum class ToneMappingOperator {
+	CLAMP, REINHARD
+};
+
+/// <summary>
+/// Turns the high dynamic range colors of a FilmBuffer into an 8 bit Image.
+/// The color is scaled by 2^exposure, compressed by the operator and
+/// optionally sRGB encoded before it is quantized. The defaults (clamp,
+/// exposure 0, linear output) reproduce the plain clamping of the original
+/// renderer exactly.
+/// </summary>
+class ToneMapper
+{
+private:
+	ToneMappingOperator op;
+	float exposure;
+	bool sRGB;
+
+public:
+	ToneMapper(ToneMappingOperator op = ToneMappingOperator::CLAMP, float exposure = 0.0f, bool sRGB = false)
+		: op(op), exposure(exposure), sRGB(sRGB) {}
+
+	void setOperator(ToneMappingOperator op) { this->op = op; }
+	ToneMappingOperator getOperator() const { return op; }
+
+	/// <summary>
+	/// Exposure in stops, every step of one doubles the brightness.
+	/// </summary>
+	void setExposure(float exposure) { this->exposure = exposure; }
+	float getExposure() const { return exposure; }
+
+	void setSRGB(bool sRGB) { this->sRGB = sRGB; }
+	bool getSRGB() const { return sRGB; }
+
+	/// <summary>
+	/// Maps a single color to the displayable range [0,1].
+	/// </summary>
+	Vec3 map(const Vec3& color) const;
+
+	/// <summary>
+	/// Maps the whole film or the pixels of one tile of it into img, which
+	/// is resized to the size of the film if necessary.
+	/// </summary>
+	void apply(const FilmBuffer& film, Image& img) const;
+	void apply(const FilmBuffer& film, Image& img, const Tile& tile) const;
+};
@@ -0,0 +1,137 @@
+#include "TriangleMesh.h"
+#include <limits>
+#include <utility>
+
+TriangleMesh::TriangleMesh(const std::vector<Vec3>& vertices, const std::vector<OBJFile::IndexType>& indices,
+                           const std::vector<Vec3>& normals, const Material& material)
+	: material(material)
+{
+	if (normals.size() == vertices.size())
+		this->normals = normals;
+
+	std::vector<AABB> triangleBounds;
+	triangles.reserve(indices.size());
+	this->indices.reserve(indices.size());
+	triangleBounds.reserve(indices.size());
+	for (const OBJFile::IndexType& index : indices)
+	{
+		const Vec3& a = vertices[index[0]];
+		const Vec3& b = vertices[index[1]];
+		const Vec3& c = vertices[index[2]];
+		triangles.push_back(Triangle{ a, b - a, c - a });
+		this->indices.push_back({ uint32_t(index[0]), uint32_t(index[1]), uint32_t(index[2]) });
+
+		AABB box{ a, a };
+		box.extend(b);
+		box.extend(c);
+		triangleBounds.push_back(box);
+		if (triangleBounds.size() == 1)
+			bounds = box;
+		else
+			bounds.extend(box);
+	}
+
+	if (!triangleBounds.empty())
+		bvh = BVH(triangleBounds);
+}
+
+TriangleMesh::TriangleMesh(const OBJFile& obj, const Material& material)
+	: TriangleMesh(obj.vertices, obj.indices, obj.normals, material)
+{
+}
+
+TriangleMesh::TriangleMesh(std::vector<Triangle> triangles, std::vector<std::array<uint32_t, 3>> indices,
+                           std::vector<Vec3> normals, BVH bvh, const Material& material)
+	: triangles(std::move(triangles)), indices(std::move(indices)), normals(std::move(normals)),
+	  bvh(std::move(bvh)), material(material)
+{
+	// the root box of the hierarchy encloses all triangles
+	if (!this->bvh.isEmpty())
+		bounds = this->bvh.getNodes()[0].bounds;
+}
+
+Material TriangleMesh::getMaterial() const
+{
+	return material;
+}
+
+std::optional<Intersection> TriangleMesh::intersect(const Ray& ray) const
+{
+	float closestT = std::numeric_limits<float>::max();
+	float closestU = 0.0f;
+	float closestV = 0.0f;
+	int64_t closest = -1;
+
+	bvh.traverse(ray, closestT, [&](uint32_t index, float& tMax)
+	{
+		float t, u, v;
+		if (intersectTriangle(index, ray, tMax, t, u, v))
+		{
+			tMax = closestT = t;
+			closestU = u;
+			closestV = v;
+			closest = index;
+		}
+		return false;
+	});
+
+	if (closest < 0)
+		return {};
+
+	Vec3 normal;
+	if (normals.empty())
+	{
+		const Triangle& triangle = triangles[size_t(closest)];
+		normal = Vec3::normalize(Vec3::cross(triangle.edge1, triangle.edge2));
+	}
+	else
+	{
+		const std::array<uint32_t, 3>& index = indices[size_t(closest)];
+		normal = normals[index[0]] * (1.0f - closestU - closestV) + normals[index[1]] * closestU + normals[index[2]] * closestV;
+		normal = Vec3::normalize(normal);
+	}
+	return Intersection{ normal, closestT };
+}
+
+bool TriangleMesh::hits(const Ray& ray, float tMax) const
+{
+	bool hit = false;
+	bvh.traverse(ray, tMax, [&](uint32_t index, float& maxT)
+	{
+		float t, u, v;
+		hit = intersectTriangle(index, ray, maxT, t, u, v);
+		return hit;
+	});
+	return hit;
+}
+
+std::optional<AABB> TriangleMesh::getBounds() const
+{
+	if (triangles.empty())
+		return {};
+	return bounds;
+}
+
+bool TriangleMesh::intersectTriangle(uint32_t index, const Ray& ray, float tMax, float& t, float& u, float& v) const
+{
+	const Triangle& triangle = triangles[index];
+
+	const Vec3 p = Vec3::cross(ray.getDirection(), triangle.edge2);
+	const float det = Vec3::dot(triangle.edge1, p);
+	if (det == 0.0f)
+		return false;	// ray parallel to the triangle
+	const float invDet = 1.0f / det;
+
+	const Vec3 s = ray.getOrigin() - triangle.v0;
+	u = Vec3::dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	const Vec3 q = Vec3::cross(s, triangle.edge1);
+	v = Vec3::dot(ray.getDirection(), q) * invDet;
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	t = Vec3::dot(triangle.edge2, q) * invDet;
+	return t > MIN_T && t <= tMax;
+}
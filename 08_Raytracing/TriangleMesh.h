@@ -0,0 +1,70 @@
+#pragma once
+#include <OBJFile.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "BVH.h"
+#include "IntersectableObject.h"
+
+/// <summary>
+/// Triangle mesh with smoothly interpolated vertex normals. The mesh keeps a
+/// BVH over its own triangles, so the scene treats the whole mesh as a single
+/// object. Triangles are tested with the Möller-Trumbore algorithm on
+/// precomputed edge vectors.
+/// </summary>
+class TriangleMesh : public IntersectableObject
+{
+public:
+	struct Triangle
+	{
+		Vec3 v0;
+		Vec3 edge1;
+		Vec3 edge2;
+	};
+
+private:
+	// hits closer than this are ignored, otherwise secondary rays started on
+	// the interpolated surface may hit their own triangle again
+	static constexpr float MIN_T = 0.0001f;
+
+	std::vector<Triangle> triangles;
+	std::vector<std::array<uint32_t, 3>> indices;
+	std::vector<Vec3> normals;	// one per vertex, empty for flat shading
+	AABB bounds;
+	BVH bvh;
+	const Material material;
+
+public:
+	/// <summary>
+	/// normals holds one normal per vertex or is empty, in that case the
+	/// geometric normal of every triangle is used.
+	/// </summary>
+	TriangleMesh(const std::vector<Vec3>& vertices, const std::vector<OBJFile::IndexType>& indices,
+	             const std::vector<Vec3>& normals, const Material& material);
+	TriangleMesh(const OBJFile& obj, const Material& material);
+
+	/// <summary>
+	/// Adopts triangles, vertex indices, normals and the hierarchy over the
+	/// triangles of a mesh that was built before, nothing is recomputed.
+	/// </summary>
+	TriangleMesh(std::vector<Triangle> triangles, std::vector<std::array<uint32_t, 3>> indices,
+	             std::vector<Vec3> normals, BVH bvh, const Material& material);
+	virtual ~TriangleMesh() {}
+
+	Material getMaterial() const override;
+	std::optional<Intersection> intersect(const Ray& ray) const override;
+	bool hits(const Ray& ray, float tMax) const override;
+	std::optional<AABB> getBounds() const override;
+
+	size_t getTriangleCount() const { return triangles.size(); }
+	const BVHBuildStats& getBuildStats() const { return bvh.getBuildStats(); }
+	const std::vector<Triangle>& getTriangles() const { return triangles; }
+	const std::vector<std::array<uint32_t, 3>>& getIndices() const { return indices; }
+	const std::vector<Vec3>& getNormals() const { return normals; }
+	const BVH& getBVH() const { return bvh; }
+
+private:
+	bool intersectTriangle(uint32_t index, const Ray& ray, float tMax, float& t, float& u, float& v) const;
+};
@@ -0,0 +1,368 @@
+#include <Image.h>
+#include <png.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+#include "Raytracer.h"
+#include "Scene.h"
+#include "SceneFile.h"
+
+// Headless renderer for render nodes and regression tracking: renders one of
+// the built-in scenes without opening a window, saves the image as PNG and
+// writes the timings of every phase as JSON. Scene::traceRay of this
+// exercise does not recurse yet, so --depth and the reflection scene only
+// take effect once it does; texturing-batch of 09 measures recursive tracing.
+// Like the interactive raytracer it loads its files from the working
+// directory, run it from build/.
+
+struct BatchSettings
+{
+	std::string scene = "simple";
+	std::string obj = "bunny.obj";
+	std::string sceneFile;	// text or binary scene file, replaces scene
+	std::string saveScene;	// binary scene file written after the build
+	uint32_t count = 0;	// 0 selects the default of the scene
+	uint32_t width = 600;
+	uint32_t height = 600;
+	int samples = 9;
+	int depth = 9;
+	uint32_t threads = 0;
+	uint32_t tileSize = 32;
+	uint32_t repeat = 1;
+	bool packets = false;
+	bool adaptive = false;
+	bool jitter = false;
+	uint32_t lightSamples = 0;	// 0 evaluates every light
+	uint32_t seed = 0;
+	bool linear = false;
+	float exposure = 0.0f;
+	bool reinhard = false;
+	bool sRGB = false;
+	std::string output = "render.png";
+	std::string report = "report.json";
+};
+
+struct PhaseTimings
+{
+	double sceneMilliseconds = 0.0;
+	double buildMilliseconds = 0.0;
+	std::vector<double> renderMilliseconds;
+	double toneMapMilliseconds = 0.0;
+	double saveMilliseconds = 0.0;
+	double wallMilliseconds = 0.0;
+};
+
+
+static void printUsage()
+{
+	std::cerr << "usage: raytracer-batch [options]\n"
+		<< "  --scene simple|spheres|lights|reflection|mesh|instances  scene to render (simple)\n"
+		<< "  --obj FILE        OBJ file of the mesh scene (bunny.obj, the makefile copies\n"
+		<< "                    the one of 01_OBJ/Datasets next to the executable)\n"
+		<< "  --scene-file FILE text or binary scene file to render instead of a built-in scene\n"
+		<< "  --save-scene FILE write the scene with its hierarchies to a binary scene file\n"
+		<< "  --count N         spheres, lights or instances of the stress scenes (1000, 16, 1000)\n"
+		<< "  --width N         image width (600)\n"
+		<< "  --height N        image height (600)\n"
+		<< "  --samples N       samples per pixel (9)\n"
+		<< "  --depth N         recursion depth (9)\n"
+		<< "  --threads N       worker threads, 0 uses all hardware threads (0)\n"
+		<< "  --tile N          tile size in pixels (32)\n"
+		<< "  --repeat N        number of timed renders (1)\n"
+		<< "  --packets         trace ray packets\n"
+		<< "  --adaptive        adaptive supersampling, --samples is the maximum\n"
+		<< "  --jitter          random subsample positions inside their grid cells\n"
+		<< "  --seed N          seed of the jittered positions (0)\n"
+		<< "  --light-samples N shadow rays to lights picked from the light tree, 0 uses all lights (0)\n"
+		<< "  --linear          test every object instead of using the BVH\n"
+		<< "  --exposure F      exposure in stops (0)\n"
+		<< "  --reinhard        Reinhard tone mapping instead of clamping\n"
+		<< "  --srgb            sRGB encoded output\n"
+		<< "  --output FILE     PNG image (render.png)\n"
+		<< "  --report FILE     JSON report (report.json)\n";
+}
+
+static bool parseArguments(const std::vector<std::string>& args, BatchSettings& settings)
+{
+	try
+	{
+		for (size_t i = 0; i < args.size(); ++i)
+		{
+			const std::string& arg = args[i];
+			auto value = [&]() -> const std::string& {
+				if (i + 1 >= args.size())
+					throw std::invalid_argument("missing value for " + arg);
+				return args[++i];
+			};
+
+			if (arg == "--scene") settings.scene = value();
+			else if (arg == "--obj") settings.obj = value();
+			else if (arg == "--scene-file") settings.sceneFile = value();
+			else if (arg == "--save-scene") settings.saveScene = value();
+			else if (arg == "--count") settings.count = uint32_t(std::stoul(value()));
+			else if (arg == "--width") settings.width = uint32_t(std::stoul(value()));
+			else if (arg == "--height") settings.height = uint32_t(std::stoul(value()));
+			else if (arg == "--samples") settings.samples = std::stoi(value());
+			else if (arg == "--depth") settings.depth = std::stoi(value());
+			else if (arg == "--threads") settings.threads = uint32_t(std::stoul(value()));
+			else if (arg == "--tile") settings.tileSize = uint32_t(std::stoul(value()));
+			else if (arg == "--repeat") settings.repeat = uint32_t(std::stoul(value()));
+			else if (arg == "--packets") settings.packets = true;
+			else if (arg == "--adaptive") settings.adaptive = true;
+			else if (arg == "--jitter") settings.jitter = true;
+			else if (arg == "--seed") settings.seed = uint32_t(std::stoul(value()));
+			else if (arg == "--light-samples") settings.lightSamples = uint32_t(std::stoul(value()));
+			else if (arg == "--linear") settings.linear = true;
+			else if (arg == "--exposure") settings.exposure = std::stof(value());
+			else if (arg == "--reinhard") settings.reinhard = true;
+			else if (arg == "--srgb") settings.sRGB = true;
+			else if (arg == "--output") settings.output = value();
+			else if (arg == "--report") settings.report = value();
+			else throw std::invalid_argument("unknown option " + arg);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		return false;
+	}
+
+	if (settings.width == 0 || settings.height == 0 || settings.samples < 1 || settings.repeat == 0)
+	{
+		std::cerr << "width, height, samples and repeat must be positive\n";
+		return false;
+	}
+	return true;
+}
+
+static bool createScene(BatchSettings& settings, Scene& scene)
+{
+	if (!settings.sceneFile.empty())
+	{
+		settings.scene = SceneFile::isBinary(settings.sceneFile) ? "binary file" : "text file";
+		return SceneFile::load(settings.sceneFile, scene);
+	}
+
+	if (settings.scene == "simple")
+		scene = Scene::genSimpleScene();
+	else if (settings.scene == "spheres")
+		scene = Scene::genRandomSpheres(settings.count > 0 ? settings.count : (settings.count = 1000));
+	else if (settings.scene == "lights")
+		scene = Scene::genManyLights(settings.count > 0 ? settings.count : (settings.count = 16));
+	else if (settings.scene == "reflection")
+		scene = Scene::genDeepReflection();
+	else if (settings.scene == "instances")
+		scene = Scene::genInstancedScene(settings.count > 0 ? settings.count : (settings.count = 1000));
+	else if (settings.scene == "mesh")
+	{
+		if (!std::ifstream(settings.obj))
+		{
+			std::cerr << "could not open " << settings.obj << "\n";
+			return false;
+		}
+		scene = Scene::genMeshScene(settings.obj);
+	}
+	else
+	{
+		std::cerr << "unknown scene " << settings.scene << "\n";
+		return false;
+	}
+	return true;
+}
+
+static double millisecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+	return duration.count();
+}
+
+static std::string escapeJSON(const std::string& text)
+{
+	std::string escaped;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			escaped += '\\';
+			escaped += c;
+		}
+		else if (uint8_t(c) < 0x20)
+		{
+			const char* digits = "0123456789abcdef";
+			escaped += "\\u00";
+			escaped += digits[uint8_t(c) >> 4];
+			escaped += digits[uint8_t(c) & 15];
+		}
+		else
+		{
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+static void writeReport(std::ostream& os, const BatchSettings& settings, const Raytracer& raytracer,
+                        const BVHBuildStats& buildStats, const PhaseTimings& timings)
+{
+	const std::vector<double>& renders = timings.renderMilliseconds;
+	const double bestRender = *std::min_element(renders.begin(), renders.end());
+	double meanRender = 0.0;
+	for (double ms : renders)
+		meanRender += ms;
+	meanRender /= double(renders.size());
+
+	// rays/sec counts the camera rays only, shadow and secondary rays are not tracked
+	const double averageSamples = raytracer.getAverageSampleCount();
+	const double primaryRays = averageSamples * double(settings.width) * double(settings.height);
+
+	const std::vector<TileStats>& tiles = raytracer.getTileStats();
+	double minTile = tiles.empty() ? 0.0 : tiles.front().milliseconds;
+	double maxTile = minTile;
+	for (const TileStats& tile : tiles)
+	{
+		minTile = std::min(minTile, tile.milliseconds);
+		maxTile = std::max(maxTile, tile.milliseconds);
+	}
+
+	os << std::fixed << std::setprecision(3);
+	os << "{\n"
+		<< "  \"scene\": \"" << settings.scene << "\",\n"
+		<< "  \"sceneFile\": \"" << escapeJSON(settings.sceneFile) << "\",\n"
+		<< "  \"count\": " << settings.count << ",\n"
+		<< "  \"width\": " << settings.width << ",\n"
+		<< "  \"height\": " << settings.height << ",\n"
+		<< "  \"samples\": " << settings.samples << ",\n"
+		<< "  \"depth\": " << settings.depth << ",\n"
+		<< "  \"threads\": " << raytracer.getThreadCount() << ",\n"
+		<< "  \"tileSize\": " << raytracer.getTileSize() << ",\n"
+		<< "  \"packets\": " << (settings.packets ? "true" : "false") << ",\n"
+		<< "  \"simdLevel\": \"" << toString(detectSIMDLevel()) << "\",\n"
+		<< "  \"adaptive\": " << (settings.adaptive ? "true" : "false") << ",\n"
+		<< "  \"jitter\": " << (settings.jitter ? "true" : "false") << ",\n"
+		<< "  \"seed\": " << settings.seed << ",\n"
+		<< "  \"lightSamples\": " << settings.lightSamples << ",\n"
+		<< "  \"intersectionMode\": \"" << (settings.linear ? "linear" : "bvh") << "\",\n"
+		<< "  \"exposure\": " << settings.exposure << ",\n"
+		<< "  \"toneMapping\": \"" << (settings.reinhard ? "reinhard" : "clamp") << (settings.sRGB ? "+srgb" : "") << "\",\n"
+		<< "  \"bvh\": {\n"
+		<< "    \"primitives\": " << buildStats.primitiveCount << ",\n"
+		<< "    \"nodes\": " << buildStats.nodeCount << ",\n"
+		<< "    \"leaves\": " << buildStats.leafCount << ",\n"
+		<< "    \"maxDepth\": " << buildStats.maxDepth << ",\n"
+		<< "    \"sahCost\": " << buildStats.sahCost << "\n"
+		<< "  },\n"
+		<< "  \"phasesMilliseconds\": {\n"
+		<< "    \"scene\": " << timings.sceneMilliseconds << ",\n"
+		<< "    \"build\": " << timings.buildMilliseconds << ",\n"
+		<< "    \"render\": " << bestRender << ",\n"
+		<< "    \"toneMap\": " << timings.toneMapMilliseconds << ",\n"
+		<< "    \"save\": " << timings.saveMilliseconds << "\n"
+		<< "  },\n"
+		<< "  \"renderMilliseconds\": [";
+	for (size_t i = 0; i < renders.size(); ++i)
+		os << (i ? ", " : "") << renders[i];
+	os << "],\n"
+		<< "  \"meanRenderMilliseconds\": " << meanRender << ",\n"
+		<< "  \"wallMilliseconds\": " << timings.wallMilliseconds << ",\n"
+		<< "  \"averageSamplesPerPixel\": " << averageSamples << ",\n"
+		<< "  \"primaryRays\": " << std::setprecision(0) << primaryRays << ",\n"
+		<< "  \"primaryRaysPerSecond\": " << primaryRays / (bestRender / 1000.0) << ",\n" << std::setprecision(3)
+		<< "  \"tiles\": { \"count\": " << tiles.size() << ", \"minMilliseconds\": " << minTile
+		<< ", \"maxMilliseconds\": " << maxTile << " }\n"
+		<< "}\n";
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> args{ argv + 1, argv + argc };
+	BatchSettings settings;
+	if (!parseArguments(args, settings))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	PhaseTimings timings;
+	const auto programStart = std::chrono::steady_clock::now();
+
+	auto start = programStart;
+	Scene scene;
+	if (!createScene(settings, scene))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+	scene.setIntersectionMode(settings.linear ? IntersectionMode::LINEAR : IntersectionMode::BVH);
+	scene.setLightSampling(LightSampling{ settings.lightSamples > 0, settings.lightSamples });
+	timings.sceneMilliseconds = millisecondsSince(start);
+
+	Camera camera;
+	camera.setEyePoint(Vec3{ 0.0, 0.0, 2.0 });
+	camera.setLookAt(Vec3{ 0.0, 0.0, 0.0 });
+
+	Raytracer raytracer(settings.depth, settings.samples);
+	raytracer.setCamera(camera);
+	raytracer.setThreadCount(settings.threads);
+	raytracer.setTileSize(settings.tileSize);
+	raytracer.setPacketTracing(settings.packets);
+	raytracer.setJitter(settings.jitter, settings.seed);
+	if (settings.adaptive)
+	{
+		AdaptiveSampling adaptiveSampling;
+		adaptiveSampling.enabled = true;
+		adaptiveSampling.maxSamples = settings.samples;
+		adaptiveSampling.minSamples = std::min(adaptiveSampling.minSamples, settings.samples);
+		raytracer.setAdaptiveSampling(adaptiveSampling);
+	}
+
+	// setScene builds the acceleration structures
+	start = std::chrono::steady_clock::now();
+	raytracer.setScene(scene);
+	timings.buildMilliseconds = millisecondsSince(start);
+	const BVHBuildStats buildStats = raytracer.getScene().getBuildStats();
+
+	if (!settings.saveScene.empty() && !SceneFile::saveBinary(raytracer.getScene(), settings.saveScene))
+		return EXIT_FAILURE;
+
+	for (uint32_t i = 0; i < settings.repeat; ++i)
+	{
+		start = std::chrono::steady_clock::now();
+		raytracer.render(settings.width, settings.height);
+		timings.renderMilliseconds.push_back(millisecondsSince(start));
+	}
+
+	start = std::chrono::steady_clock::now();
+	Image image(settings.width, settings.height);
+	const ToneMapper toneMapper(settings.reinhard ? ToneMappingOperator::REINHARD : ToneMappingOperator::CLAMP,
+	                            settings.exposure, settings.sRGB);
+	raytracer.setToneMapper(toneMapper);
+	raytracer.toneMap(image);
+	timings.toneMapMilliseconds = millisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	if (!PNG::save(settings.output, image, toneMapper.getSRGB()))
+	{
+		std::cerr << "could not save " << settings.output << "\n";
+		return EXIT_FAILURE;
+	}
+	timings.saveMilliseconds = millisecondsSince(start);
+	timings.wallMilliseconds = millisecondsSince(programStart);
+
+	std::ofstream report(settings.report);
+	if (!report)
+	{
+		std::cerr << "could not write " << settings.report << "\n";
+		return EXIT_FAILURE;
+	}
+	writeReport(report, settings, raytracer, buildStats, timings);
+	writeReport(std::cout, settings, raytracer, buildStats, timings);
+	return EXIT_SUCCESS;
+}
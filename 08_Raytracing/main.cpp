@@ -1,32 +1,94 @@
 #include <GLApp.h>
 #include <cmath>
+#include <memory>
 #include <optional>
 #include "Scene.h"
 #include "Camera.h"
 #include "Raytracer.h"
+#include "RenderSession.h"
+#include "SceneFile.h"
 
 class MyGLApp : public GLApp {
 public:
+  // seconds between two uploads of the progressive image
+  static constexpr double SNAPSHOT_INTERVAL = 0.1;
+  static constexpr float MOVE_STEP = 0.25f;
+  static constexpr float EXPOSURE_STEP = 0.5f;
+
   Image image{600,600};
+  std::string sceneFile;  // text or binary scene file given on the command line
+  Camera camera;
+  std::unique_ptr<RenderSession> session;
+  double lastSnapshot = 0.0;
   
   MyGLApp() : GLApp{600,600,1,"Raytrace Demo"} {}
     
   virtual void init() {
     GL(glDisable(GL_CULL_FACE));
-    render(Scene::genSimpleScene(), 9);
+    camera.setEyePoint(Vec3{ 0.0, 0.0, 2.0 });
+    camera.setLookAt(Vec3{ 0.0, 0.0, 0.0 });
+    Scene scene;
+    if (sceneFile.empty() || !SceneFile::load(sceneFile, scene))
+      scene = Scene::genSimpleScene();
+    render(scene, 9);
   }
 
   void render(Scene scene, int depth) {
-      Camera camera;
-      camera.setEyePoint(Vec3{ 0.0, 0.0, 2.0 });
-      camera.setLookAt(Vec3{ 0.0, 0.0, 0.0 });
-
       // instantiates the actual renderer with recursion depth 9 and 9x super sampling
       // NOTE: you might want to reduce the super sampling to 1 for testing and debugging
       Raytracer renderer(depth, 9);
       renderer.setCamera(camera);
       renderer.setScene(scene);
-      renderer.render(image);
+
+      // render in the background and show the image while it converges
+      session = std::make_unique<RenderSession>(renderer, image.width, image.height);
+      session->start();
+  }
+
+  virtual void animate(double animationTime) {
+    if (animationTime - lastSnapshot < SNAPSHOT_INTERVAL)
+      return;
+    session->update(image);
+    lastSnapshot = animationTime;
+  }
+
+  virtual void keyboard(int key, int scancode, int action, int mods) {
+    if (action != GLENV_PRESS)
+      return;
+
+    // changing the tone mapping does not trace any rays
+    ToneMapper toneMapper = session->getToneMapper();
+    switch (key) {
+      case GLENV_KEY_E:
+        toneMapper.setExposure(toneMapper.getExposure() + EXPOSURE_STEP);
+        session->setToneMapper(toneMapper);
+        return;
+      case GLENV_KEY_Q:
+        toneMapper.setExposure(toneMapper.getExposure() - EXPOSURE_STEP);
+        session->setToneMapper(toneMapper);
+        return;
+      case GLENV_KEY_T:
+        toneMapper.setOperator(toneMapper.getOperator() == ToneMappingOperator::CLAMP ? ToneMappingOperator::REINHARD : ToneMappingOperator::CLAMP);
+        toneMapper.setSRGB(toneMapper.getOperator() == ToneMappingOperator::REINHARD);
+        session->setToneMapper(toneMapper);
+        return;
+    }
+
+    const Vec3 right = Vec3::normalize(Vec3::cross(camera.getViewDir(), camera.getUpDir()));
+    Vec3 move;
+    switch (key) {
+      case GLENV_KEY_W: move = camera.getViewDir() * MOVE_STEP; break;
+      case GLENV_KEY_S: move = camera.getViewDir() * -MOVE_STEP; break;
+      case GLENV_KEY_D: move = right * MOVE_STEP; break;
+      case GLENV_KEY_A: move = right * -MOVE_STEP; break;
+      case GLENV_KEY_UP: move = camera.getUpDir() * MOVE_STEP; break;
+      case GLENV_KEY_DOWN: move = camera.getUpDir() * -MOVE_STEP; break;
+      default: return;
+    }
+
+    // the old image stays visible until the new tiles come in
+    camera.setEyePoint(camera.getEyePoint() + move);
+    session->restart(camera);
   }
 
   virtual void draw() {
@@ -44,6 +106,8 @@ INT WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR lpCmdLine, INT nC
 int main(int argc, char** argv) {
     std::vector<std::string> args{ argv + 1, argv + argc };
 #endif
+    if (!args.empty())
+        myApp.sceneFile = args[0];
     try {
         myApp.run();
     }
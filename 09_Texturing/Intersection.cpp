@@ -1,8 +1,13 @@
 #include "Intersection.h"
 
-Material Intersection::getMaterial() const
+uint32_t Intersection::getMaterialID() const
 {
-    return material;
+    return materialID;
+}
+
+void Intersection::setMaterialID(uint32_t materialID)
+{
+    this->materialID = materialID;
 }
 
 Vec3 Intersection::getNormal() const
@@ -19,3 +24,13 @@ std::optional<TextureCoordinates> Intersection::getTexCoords() const
 {
     return texCoords;
 }
+
+std::optional<TextureDifferentials> Intersection::getTexDifferentials() const
+{
+    return texDifferentials;
+}
+
+void Intersection::setTexDifferentials(const std::optional<TextureDifferentials>& texDifferentials)
+{
+    this->texDifferentials = texDifferentials;
+}
@@ -1,25 +1,40 @@
 #pragma once
-#include "Material.h"
+#include <cstdint>
+#include <optional>
 #include <Vec3.h>
 #include "TextureCoordinates.h"
 
+/// <summary>
+/// Hit data of a ray. The material is only referenced by its index into the
+/// material table of the Scene, objects create intersections without it and
+/// Scene::intersect fills in the index of the closest hit.
+/// </summary>
 class Intersection
 {
 private:
-	Material material;
+	uint32_t materialID;
 	Vec3 normal;
 	std::optional<TextureCoordinates> texCoords;
+	std::optional<TextureDifferentials> texDifferentials;
 	float t;
 
 public:
-	Intersection(const Material& material, const Vec3& normal, const std::optional<TextureCoordinates>& texCoords, float t)
-		: material(material), normal(normal), texCoords(texCoords), t(t)
+	Intersection(const Vec3& normal, const std::optional<TextureCoordinates>& texCoords, float t)
+		: materialID(0), normal(normal), texCoords(texCoords), t(t)
 	{ };
 
-	Material getMaterial() const;
+	uint32_t getMaterialID() const;
+	void setMaterialID(uint32_t materialID);
 	Vec3 getNormal() const;
 	float getT() const;
 	std::optional<TextureCoordinates> getTexCoords() const;
 
+	/// <summary>
+	/// Set by Scene::intersect for rays with differentials that hit a
+	/// textured object, empty otherwise.
+	/// </summary>
+	std::optional<TextureDifferentials> getTexDifferentials() const;
+	void setTexDifferentials(const std::optional<TextureDifferentials>& texDifferentials);
+
 };
 
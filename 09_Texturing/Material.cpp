@@ -65,7 +65,7 @@ float Material::getReflectivity(float cosI) const
     return R0 + (1.0f - R0) * powf(1.0f - sign * cosI, 5);
 }
 
-std::optional<Texture> Material::getTexture() const
+const std::optional<Texture>& Material::getTexture() const
 {
     return texture;
 }
@@ -69,6 +69,6 @@ public:
 
 	float getReflectivity(float cosI) const;
 
-	std::optional<Texture> getTexture() const;
+	const std::optional<Texture>& getTexture() const;
 };
 
@@ -22,7 +22,7 @@ std::optional<Intersection> Plane::intersect(const Ray& ray) const
         p - center;
         tc = TextureCoordinates(Vec3::dot(p, frame1), Vec3::dot(p, frame2));
     }
-    return Intersection{ material, normal, tc, t };
+    return Intersection{ normal, tc, t };
 }
 
 void Plane::buildLocalFrame()
@@ -14,3 +14,13 @@ Vec3 Ray::getPosOnRay(float t) const
 {
     return origin + direction * t;
 }
+
+const std::optional<RayDifferentials>& Ray::getDifferentials() const
+{
+    return differentials;
+}
+
+void Ray::setDifferentials(const std::optional<RayDifferentials>& differentials)
+{
+    this->differentials = differentials;
+}
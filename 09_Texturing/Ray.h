@@ -1,19 +1,40 @@
 #pragma once
 #include <Vec3.h>
+#include <optional>
+
+/// <summary>
+/// Ray differentials: origins and directions of two auxiliary rays offset by
+/// one sample in x and y on the image plane. Where they hit the surface tells
+/// how large the footprint of the ray is, see Texture::sample.
+/// </summary>
+struct RayDifferentials
+{
+	Vec3 dxOrigin;
+	Vec3 dxDirection;
+	Vec3 dyOrigin;
+	Vec3 dyDirection;
+};
 
 class Ray
 {
 private:
 	Vec3 origin;
 	Vec3 direction;
+	std::optional<RayDifferentials> differentials;
 
 public:
 	Ray(const Vec3& origin, const Vec3& direction)
 		: origin(origin), direction(direction)
 	{ }
 
+	Ray(const Vec3& origin, const Vec3& direction, const std::optional<RayDifferentials>& differentials)
+		: origin(origin), direction(direction), differentials(differentials)
+	{ }
+
 	Vec3 getOrigin() const;
 	Vec3 getDirection() const;
 	Vec3 getPosOnRay(float t) const;
-};
 
+	const std::optional<RayDifferentials>& getDifferentials() const;
+	void setDifferentials(const std::optional<RayDifferentials>& differentials);
+};
@@ -1,5 +1,6 @@
 #define _USE_MATH_DEFINES
 #include "Raytracer.h"
+#include <algorithm>
 #include <cmath>
 
 void Raytracer::setCamera(const Camera& camera)
@@ -12,9 +13,31 @@ void Raytracer::setScene(const Scene& scene)
     this->scene = scene;
 }
 
+void Raytracer::setWavefront(bool wavefront, bool sortByMaterial)
+{
+    this->wavefront = wavefront;
+    this->sortByMaterial = sortByMaterial;
+}
+
+bool Raytracer::getWavefront() const
+{
+    return wavefront;
+}
+
+const std::vector<BounceStats>& Raytracer::getBounceStats() const
+{
+    return bounceStats;
+}
+
 void Raytracer::render(Image& img)
 {
+    bounceStats.clear();
     RaySetup rs = computeRaySetup(img);
+    if (wavefront)
+    {
+        renderWavefront(img, rs);
+        return;
+    }
 
     int numSamples = numSamplesX * numSamplesY;
     for (uint32_t y = 0; y < img.height; ++y)
@@ -47,16 +70,75 @@ void Raytracer::render(Image& img)
     }
 }
 
+void Raytracer::renderWavefront(Image& img, const RaySetup& rs)
+{
+    // a block of rows per wavefront keeps the ray queues small enough to stay in the cache
+    const uint32_t rowsPerWavefront = 8;
+    const int numSamples = numSamplesX * numSamplesY;
+
+    std::vector<Ray> rays;
+    std::vector<Vec3> colors;
+    for (uint32_t y0 = 0; y0 < img.height; y0 += rowsPerWavefront)
+    {
+        const uint32_t y1 = std::min(y0 + rowsPerWavefront, img.height);
+
+        // same sample positions and order as render
+        rays.clear();
+        for (uint32_t y = y0; y < y1; ++y)
+        {
+            for (uint32_t x = 0; x < img.width; ++x)
+            {
+                if (numSamples == 1)
+                {
+                    rays.push_back(computeRay(float(x), float(y), rs));
+                    continue;
+                }
+                for (int sY = 0; sY < numSamplesY; ++sY)
+                    for (int sX = 0; sX < numSamplesX; ++sX)
+                        rays.push_back(computeRay(x + sX / ((float)numSamplesX), y + sY / ((float)numSamplesY), rs));
+            }
+        }
+
+        scene.traceWavefront(rays, recDepth, sortByMaterial, colors, &bounceStats);
+
+        size_t sample = 0;
+        for (uint32_t y = y0; y < y1; ++y)
+        {
+            for (uint32_t x = 0; x < img.width; ++x)
+            {
+                Vec3 color;
+                for (int s = 0; s < numSamples; ++s)
+                    color = color + colors[sample++];
+                if (numSamples != 1)
+                    color = color / float(numSamples);
+                img.setNormalizedValue(x, y, 0, color.r);
+                img.setNormalizedValue(x, y, 1, color.g);
+                img.setNormalizedValue(x, y, 2, color.b);
+                img.setValue(x, y, 3, 255);
+            }
+        }
+    }
+}
+
 Vec3 Raytracer::traceRay(const Ray& r)
 {
-    return scene.traceRay(r, 1.0, recDepth);
+    return scene.traceRay(r, 1.0, recDepth, &bounceStats);
 }
 
 Ray Raytracer::computeRay(float x, float y, const RaySetup& rs) const
 {
     Vec3 dir{ rs.bottomLeft + rs.dX * x + rs.dY * y };
     dir = Vec3::normalize(dir);
-    return Ray{ rs.rayOrigin, dir };
+
+    // the auxiliary rays pass through the neighboring subsamples
+    const float stepX = 1.0f / float(numSamplesX);
+    const float stepY = 1.0f / float(numSamplesY);
+    RayDifferentials differentials;
+    differentials.dxOrigin = rs.rayOrigin;
+    differentials.dxDirection = Vec3::normalize(rs.bottomLeft + rs.dX * (x + stepX) + rs.dY * y);
+    differentials.dyOrigin = rs.rayOrigin;
+    differentials.dyDirection = Vec3::normalize(rs.bottomLeft + rs.dX * x + rs.dY * (y + stepY));
+    return Ray{ rs.rayOrigin, dir, differentials };
 }
 
 RaySetup Raytracer::computeRaySetup(const Image& img)
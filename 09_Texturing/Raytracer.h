@@ -2,6 +2,8 @@
 #include <Vec3.h>
 #include <Image.h>
 
+#include <vector>
+
 #include "Camera.h"
 #include "Scene.h"
 
@@ -21,12 +23,15 @@ private:
 	int recDepth;
 	int numSamplesX;
 	int numSamplesY;
+	bool wavefront;
+	bool sortByMaterial;
 	Camera camera;
 	Scene scene;
+	std::vector<BounceStats> bounceStats;
 
 public:
 	Raytracer(int recDepth, int numSamples)
-		: recDepth(recDepth)
+		: recDepth(recDepth), wavefront(false), sortByMaterial(true)
 	{
 		numSamplesX = (int)sqrtf(float(numSamples));
 		numSamplesY = numSamples / numSamplesX;
@@ -36,7 +41,23 @@ public:
 	void setScene(const Scene& scene);
 	void render(Image& img);
 
+	/// <summary>
+	/// In wavefront mode the camera rays of a block of rows are traced
+	/// together with Scene::traceWavefront instead of one by one with the
+	/// recursive Scene::traceRay.
+	/// </summary>
+	void setWavefront(bool wavefront, bool sortByMaterial = true);
+	bool getWavefront() const;
+
+	/// <summary>
+	/// Reflected and refracted rays spawned, terminated and kept alive by the
+	/// russian roulette per bounce during the last call of render, see
+	/// Scene::setRayTermination.
+	/// </summary>
+	const std::vector<BounceStats>& getBounceStats() const;
+
 private:
+	void renderWavefront(Image& img, const RaySetup& rs);
 	Vec3 traceRay(const Ray& r);
 	Ray computeRay(float x, float y, const RaySetup& rs) const;
 	RaySetup computeRaySetup(const Image& img);
@@ -4,11 +4,16 @@
 #include "Sphere.h"
 #include "Plane.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <numeric>
 
 #include "Texture.h"
 
 void Scene::addObject(std::shared_ptr<const IntersectableObject> object) {
+	objectMaterials.push_back(uint32_t(materials.size()));
+	materials.push_back(object->getMaterial());
 	sceneObjects.push_back(object);
 }
 
@@ -20,24 +25,102 @@ Vec3 Scene::getBackgroundcolor() const {
 	return backgroundColor;
 }
 
+const Material& Scene::getMaterial(uint32_t materialID) const {
+	return materials[materialID];
+}
+
+size_t Scene::getMaterialCount() const {
+	return materials.size();
+}
+
 std::optional<Intersection> Scene::intersect(const Ray& ray,
                                              bool shadowRay) const {
 	std::optional<Intersection> result{};
-	for (std::shared_ptr<const IntersectableObject> object : sceneObjects)
+	size_t resultIndex = 0;
+	for (size_t index = 0; index < sceneObjects.size(); ++index)
 	{
-		if (shadowRay && !object->getMaterial().isShadowCaster())
+		if (shadowRay && !materials[objectMaterials[index]].isShadowCaster())
 			continue;
 
-		std::optional<Intersection> i = object->intersect(ray);
+		std::optional<Intersection> i = sceneObjects[index]->intersect(ray);
 		if (!i.has_value())
 			continue;
 
-		if (!result.has_value() || i.value().getT() < result.value().getT())
+		if (!result.has_value() || i.value().getT() < result.value().getT()) {
 			result = i;
+			resultIndex = index;
+		}
+	}
+
+	// the material is resolved only for the closest hit
+	if (result.has_value())
+		result->setMaterialID(objectMaterials[resultIndex]);
+
+	// mipmapped textures need the footprint of the ray
+	if (result.has_value() && !shadowRay && ray.getDifferentials().has_value() && result->getTexCoords().has_value()) {
+		const Material& material = materials[objectMaterials[resultIndex]];
+		if (material.hasTexture() && material.getTexture()->getFilterMode() == FilterMode::TRILINEAR)
+			result->setTexDifferentials(texDifferentials(ray, *sceneObjects[resultIndex], result->getTexCoords().value()));
 	}
 	return result;
 }
 
+/// <summary>
+/// Differences between the texture coordinates of a hit and those of the
+/// auxiliary rays of its differentials on the same object. Nothing if one of
+/// them misses the object.
+/// </summary>
+std::optional<TextureDifferentials> Scene::texDifferentials(const Ray& ray, const IntersectableObject& object,
+                                                            const TextureCoordinates& texCoords) const {
+	const RayDifferentials& differentials = ray.getDifferentials().value();
+	std::optional<Intersection> hitX = object.intersect(Ray{ differentials.dxOrigin, differentials.dxDirection });
+	std::optional<Intersection> hitY = object.intersect(Ray{ differentials.dyOrigin, differentials.dyDirection });
+	if (!hitX.has_value() || !hitY.has_value() || !hitX->getTexCoords().has_value() || !hitY->getTexCoords().has_value())
+		return {};
+
+	const TextureCoordinates tcX = hitX->getTexCoords().value();
+	const TextureCoordinates tcY = hitY->getTexCoords().value();
+	return TextureDifferentials{ { tcX.u - texCoords.u, tcX.v - texCoords.v },
+	                             { tcY.u - texCoords.u, tcY.v - texCoords.v } };
+}
+
+/// <summary>
+/// Differentials of the ray leaving a hit, reflected if IOR is empty and
+/// refracted otherwise. The auxiliary rays are intersected with the tangent
+/// plane of the hit and bent about the same normal, so the curvature of the
+/// surface is ignored.
+/// </summary>
+std::optional<RayDifferentials> Scene::bendDifferentials(const Ray& ray, const Intersection& inter,
+                                                         const std::optional<float>& IOR) const {
+	const std::optional<RayDifferentials>& differentials = ray.getDifferentials();
+	if (!differentials.has_value())
+		return {};
+
+	const Vec3 normal = inter.getNormal();
+	const float planeD = Vec3::dot(ray.getPosOnRay(inter.getT()), normal);
+	const float denomX = Vec3::dot(differentials->dxDirection, normal);
+	const float denomY = Vec3::dot(differentials->dyDirection, normal);
+	if (denomX == 0.0f || denomY == 0.0f)
+		return {};
+
+	RayDifferentials result;
+	result.dxOrigin = differentials->dxOrigin + differentials->dxDirection * ((planeD - Vec3::dot(differentials->dxOrigin, normal)) / denomX);
+	result.dyOrigin = differentials->dyOrigin + differentials->dyDirection * ((planeD - Vec3::dot(differentials->dyOrigin, normal)) / denomY);
+	if (!IOR.has_value()) {
+		result.dxDirection = Vec3::reflect(differentials->dxDirection, normal);
+		result.dyDirection = Vec3::reflect(differentials->dyDirection, normal);
+		return result;
+	}
+
+	std::optional<Vec3> dxDirection = Vec3::refract(differentials->dxDirection, normal, IOR.value());
+	std::optional<Vec3> dyDirection = Vec3::refract(differentials->dyDirection, normal, IOR.value());
+	if (!dxDirection.has_value() || !dyDirection.has_value())
+		return {};
+	result.dxDirection = dxDirection.value();
+	result.dyDirection = dyDirection.value();
+	return result;
+}
+
 /// <summary>
 /// Trace a ray through the scene and compute its color value.
 /// </summary>
@@ -46,6 +129,18 @@ std::optional<Intersection> Scene::intersect(const Ray& ray,
 /// <param name="recDepth">recursion depth</param>
 /// <returns>final color value computed for this ray</returns>
 Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth) const {
+	return traceRay(ray, IOR, recDepth, 0, 1.0f, nullptr);
+}
+
+Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth, std::vector<BounceStats>* stats) const {
+	return traceRay(ray, IOR, recDepth, 0, 1.0f, stats);
+}
+
+/// <summary>
+/// Recursive part of traceRay, bounce counts the reflections and refractions
+/// so far and contribution is the weight of this ray's color in its pixel.
+/// </summary>
+Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth, int bounce, float contribution, std::vector<BounceStats>* stats) const {
 	if (recDepth == 0) return backgroundColor;
 
 	// no intersection found
@@ -54,6 +149,7 @@ Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth) const {
 
 	// else intersection found, do recursive ray tracing
 	Intersection inter = opt_intersection.value();
+	const Material& material = materials[inter.getMaterialID()];
 	Vec3 interPos = ray.getPosOnRay(inter.getT());
 
 	if (debug) {
@@ -65,55 +161,243 @@ Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth) const {
 
 	Vec3 offSurfacePos = interPos + inter.getNormal() * OFFSET_EPSILON;
 
+	// the weights decide whether the reflected and refracted rays are worth tracing
+	float l, r, t;
+	computeWeights(ray, inter, material, l, r, t);
+
+	// at the last bounce the spawned rays only return the background color
+	// without being intersected, so they are not counted
+	std::vector<BounceStats>* spawnStats = recDepth > 1 ? stats : nullptr;
+
 	Vec3 reflColor{ 0.0f, 0.0f, 0.0f };
-	if (inter.getMaterial().reflects()) {
-		Ray reflRay{ offSurfacePos, Vec3::reflect(ray.getDirection(), inter.getNormal()) };
-		reflColor = traceRay(reflRay, IOR, recDepth - 1);
+	if (material.reflects()) {
+		Ray reflRay{ offSurfacePos, Vec3::reflect(ray.getDirection(), inter.getNormal()), bendDifferentials(ray, inter, {}) };
+		float survival = survivalWeight(reflRay, contribution * r, bounce, spawnStats);
+		if (survival > 0.0f) {
+			reflColor = traceRay(reflRay, IOR, recDepth - 1, bounce + 1, contribution * r * survival, stats) * survival;
+		}
 	}
 
 	Vec3 refractionColor{ 0.0f, 0.0f, 0.0f };
-	if (inter.getMaterial().refracts()) {
-		std::optional<Vec3> refrDirection = Vec3::refract(ray.getDirection(), inter.getNormal(), inter.getMaterial().getIndexOfRefraction().value());
-		if (refrDirection.has_value()) {
-			if (IOR == 1.0) {
-				// Ray --> from air into material
-				Vec3 inSurfacePos = interPos + inter.getNormal() * -OFFSET_EPSILON;
-				Ray refrRay{ inSurfacePos, refrDirection.value() };
-				refractionColor = traceRay(refrRay, inter.getMaterial().getIndexOfRefraction().value(), recDepth - 1);
-			} else {
-				// Ray --> from material into air
-				Ray refrRay{ offSurfacePos, refrDirection.value() };
-				refractionColor = traceRay(refrRay, 1.0, recDepth - 1);
+	float refrIOR;
+	std::optional<Ray> refrRay = refractedRay(ray, inter, material, IOR, refrIOR);
+	if (refrRay.has_value()) {
+		float survival = survivalWeight(refrRay.value(), contribution * t, bounce, spawnStats);
+		if (survival > 0.0f) {
+			refractionColor = traceRay(refrRay.value(), refrIOR, recDepth - 1, bounce + 1, contribution * t * survival, stats) * survival;
+		}
+	}
+
+	Vec3 localColor = shadeLocal(ray, inter, material, offSurfacePos);
+
+	// compose final color
+	return localColor * l + reflColor * r + refractionColor * t;
+}
+
+void Scene::traceWavefront(const std::vector<Ray>& rays, int recDepth, bool sortByMaterial, std::vector<Vec3>& colors,
+                           std::vector<BounceStats>* stats) const {
+	colors.assign(rays.size(), Vec3{ 0.0f, 0.0f, 0.0f });
+
+	std::vector<WavefrontRay> wavefront;
+	std::vector<WavefrontRay> nextWavefront;
+	wavefront.reserve(rays.size());
+	for (uint32_t i = 0; i < uint32_t(rays.size()); ++i) {
+		wavefront.push_back(WavefrontRay{ rays[i], Vec3{ 1.0f, 1.0f, 1.0f }, 1.0f, i });
+	}
+
+	std::vector<std::optional<Intersection>> hits;
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> bucketStart;
+	for (int depth = recDepth; depth > 0 && !wavefront.empty(); --depth) {
+		// intersect the whole wavefront in one go
+		hits.resize(wavefront.size());
+		for (size_t i = 0; i < wavefront.size(); ++i) {
+			hits[i] = intersect(wavefront[i].ray, false);
+		}
+
+		// shading hits of the same material one after another keeps the
+		// material and its texture in the cache, misses go last
+		order.resize(wavefront.size());
+		if (sortByMaterial) {
+			// counting sort, there are only a few materials
+			const size_t missBucket = materials.size();
+			bucketStart.assign(materials.size() + 2, 0);
+			for (size_t i = 0; i < wavefront.size(); ++i) {
+				++bucketStart[(hits[i].has_value() ? hits[i]->getMaterialID() : missBucket) + 1];
+			}
+			std::partial_sum(bucketStart.begin(), bucketStart.end(), bucketStart.begin());
+			for (uint32_t i = 0; i < uint32_t(wavefront.size()); ++i) {
+				order[bucketStart[hits[i].has_value() ? hits[i]->getMaterialID() : missBucket]++] = i;
+			}
+		} else {
+			std::iota(order.begin(), order.end(), 0);
+		}
+
+		nextWavefront.clear();
+		for (uint32_t i : order) {
+			const WavefrontRay& wr = wavefront[i];
+			if (!hits[i].has_value()) {
+				colors[wr.sample] = colors[wr.sample] + wr.weight * backgroundColor;
+				continue;
 			}
+
+			const Intersection& inter = hits[i].value();
+			const Material& material = materials[inter.getMaterialID()];
+
+			if (debug) {
+				std::optional<TextureCoordinates> tc = inter.getTexCoords();
+				if (tc.has_value()) {
+					colors[wr.sample] = colors[wr.sample] + wr.weight * Vec3::clamp({ tc->u, tc->v, 0 }, 0, 1);
+					continue;
+				}
+			}
+
+			Vec3 offSurfacePos = wr.ray.getPosOnRay(inter.getT()) + inter.getNormal() * OFFSET_EPSILON;
+
+			float l, r, t;
+			computeWeights(wr.ray, inter, material, l, r, t);
+			colors[wr.sample] = colors[wr.sample] + wr.weight * (shadeLocal(wr.ray, inter, material, offSurfacePos) * l);
+
+			// the spawned rays carry the weight of their contribution to the camera ray,
+			// those of the last bounce are not counted as they are never intersected
+			const int bounce = recDepth - depth;
+			const float contribution = std::max({ wr.weight.r, wr.weight.g, wr.weight.b });
+			std::vector<BounceStats>* spawnStats = depth > 1 ? stats : nullptr;
+			if (material.reflects()) {
+				Ray reflRay{ offSurfacePos, Vec3::reflect(wr.ray.getDirection(), inter.getNormal()), bendDifferentials(wr.ray, inter, {}) };
+				float survival = survivalWeight(reflRay, contribution * r, bounce, spawnStats);
+				if (survival > 0.0f) {
+					nextWavefront.push_back(WavefrontRay{ reflRay, wr.weight * r * survival, wr.IOR, wr.sample });
+				}
+			}
+			float refrIOR;
+			std::optional<Ray> refrRay = refractedRay(wr.ray, inter, material, wr.IOR, refrIOR);
+			if (refrRay.has_value()) {
+				float survival = survivalWeight(refrRay.value(), contribution * t, bounce, spawnStats);
+				if (survival > 0.0f) {
+					nextWavefront.push_back(WavefrontRay{ refrRay.value(), wr.weight * t * survival, refrIOR, wr.sample });
+				}
+			}
+		}
+		std::swap(wavefront, nextWavefront);
+	}
+
+	// traceRay returns the background color once the recursion depth is used up
+	for (const WavefrontRay& wr : wavefront) {
+		colors[wr.sample] = colors[wr.sample] + wr.weight * backgroundColor;
+	}
+}
+
+/// <summary>
+/// Uniform number in [0, 1) for the russian roulette, derived from the ray
+/// itself so that renders are repeatable and the recursive and the wavefront
+/// traversal make the same decisions.
+/// </summary>
+static float rouletteSample(const Ray& ray, int bounce) {
+	const Vec3 origin = ray.getOrigin();
+	const Vec3 direction = ray.getDirection();
+	const float values[6] = { origin.x, origin.y, origin.z, direction.x, direction.y, direction.z };
+
+	uint32_t h = uint32_t(bounce) * 0x9E3779B9u;
+	for (float value : values) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		h ^= bits + 0x9E3779B9u + (h << 6) + (h >> 2);
+	}
+	// final avalanche (murmur3)
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return float(h >> 8) * (1.0f / 16777216.0f);
+}
+
+/// <summary>
+/// Decides whether a reflected or refracted ray with the given contribution
+/// to its pixel is traced. Returns the factor its color has to be scaled
+/// with, 1 for rays above the threshold, 1/p for rays that survived the
+/// russian roulette with probability p and 0 for terminated rays.
+/// </summary>
+float Scene::survivalWeight(const Ray& ray, float contribution, int bounce, std::vector<BounceStats>* stats) const {
+	if (stats && stats->size() <= size_t(bounce)) {
+		stats->resize(size_t(bounce) + 1);
+	}
+	if (stats) ++(*stats)[bounce].spawned;
+
+	if (!termination.enabled || contribution >= termination.threshold) {
+		return 1.0f;
+	}
+
+	if (termination.russianRoulette && contribution > 0.0f) {
+		const float p = contribution / termination.threshold;
+		if (rouletteSample(ray, bounce) < p) {
+			if (stats) ++(*stats)[bounce].survived;
+			return 1.0f / p;
 		}
 	}
 
+	if (stats) ++(*stats)[bounce].terminated;
+	return 0.0f;
+}
+
+/// <summary>
+/// Refracted continuation of a ray that hit a refracting material, nothing
+/// for other materials and on total internal reflection. refrIOR receives
+/// the optical density of the medium the refracted ray travels in.
+/// </summary>
+std::optional<Ray> Scene::refractedRay(const Ray& ray, const Intersection& inter, const Material& material, float IOR, float& refrIOR) const {
+	if (!material.refracts())
+		return {};
+
+	std::optional<Vec3> refrDirection = Vec3::refract(ray.getDirection(), inter.getNormal(), material.getIndexOfRefraction().value());
+	if (!refrDirection.has_value())
+		return {};
+
+	Vec3 interPos = ray.getPosOnRay(inter.getT());
+	if (IOR == 1.0) {
+		// Ray --> from air into material
+		refrIOR = material.getIndexOfRefraction().value();
+		Vec3 inSurfacePos = interPos + inter.getNormal() * -OFFSET_EPSILON;
+		return Ray{ inSurfacePos, refrDirection.value(), bendDifferentials(ray, inter, material.getIndexOfRefraction()) };
+	} else {
+		// Ray --> from material into air
+		refrIOR = 1.0;
+		Vec3 offSurfacePos = interPos + inter.getNormal() * OFFSET_EPSILON;
+		return Ray{ offSurfacePos, refrDirection.value(), bendDifferentials(ray, inter, material.getIndexOfRefraction()) };
+	}
+}
+
+/// <summary>
+/// Local illumination of a hit by all light sources.
+/// </summary>
+Vec3 Scene::shadeLocal(const Ray& ray, const Intersection& inter, const Material& material, const Vec3& offSurfacePos) const {
 	Vec3 localColor{ 0.0f, 0.0f, 0.0f };
 	Vec3 textureColor{1.0f, 1.0f, 1.0f}; // multiplication with this color results in same color value
-	if(inter.getMaterial().hasTexture() && inter.getTexCoords().has_value()) {
-		textureColor = inter.getMaterial().getTexture().value().sample(inter.getTexCoords().value());
+	if(material.hasTexture() && inter.getTexCoords().has_value()) {
+		textureColor = material.getTexture()->sample(inter.getTexCoords().value(), inter.getTexDifferentials());
 	}
 
 	for (const std::shared_ptr<const LightSource>& ls : lightSources) {
 		Ray shadowRay{ offSurfacePos, ls->getDirection(offSurfacePos) };
 		std::optional<Intersection> shadowInter = intersect(shadowRay, true);
 
-		Vec3 ambient = inter.getMaterial().getAmbient() * ls->getAmbient();
-		if (inter.getMaterial().hasTexture()) {
+		Vec3 ambient = material.getAmbient() * ls->getAmbient();
+		if (material.hasTexture()) {
 			ambient = ambient * textureColor;
 		}
 
 		if (!shadowInter.has_value() || shadowInter->getT() > ls->getDistance(offSurfacePos)) {
 			float d = Vec3::dot(ls->getDirection(offSurfacePos), inter.getNormal());
-			Vec3 diffuse = inter.getMaterial().getDiffuse() * ls->getDiffuse() * d;
+			Vec3 diffuse = material.getDiffuse() * ls->getDiffuse() * d;
 			diffuse = Vec3::clamp(diffuse, 0.0f, 1.0f);
-			if (inter.getMaterial().hasTexture()) {
+			if (material.hasTexture()) {
 				diffuse = diffuse * textureColor;
 			}
 
 			Vec3 Rv = Vec3::reflect(ray.getDirection(), inter.getNormal());
-			float s = pow(std::max(0.0f, Vec3::dot(Rv, ls->getDirection(offSurfacePos))), inter.getMaterial().getExp());
-			Vec3 specular = inter.getMaterial().getSpecular() * ls->getSpecular() * s;
+			float s = pow(std::max(0.0f, Vec3::dot(Rv, ls->getDirection(offSurfacePos))), material.getExp());
+			Vec3 specular = material.getSpecular() * ls->getSpecular() * s;
 			specular = Vec3::clamp(specular, 0.0f, 1.0f);
 
 			localColor = localColor + ambient + diffuse + specular;
@@ -122,22 +406,29 @@ Vec3 Scene::traceRay(const Ray& ray, float IOR, int recDepth) const {
 		}
 	}
 
-	// compose final color
+	return localColor;
+}
+
+/// <summary>
+/// Weights of the local color (l), the reflected (r) and the refracted (t) color of a hit.
+/// </summary>
+void Scene::computeWeights(const Ray& ray, const Intersection& inter, const Material& material, float& l, float& r, float& t) const {
 	float cosI = Vec3::dot(ray.getDirection(), inter.getNormal());
-	float l = 0, r = 0, t = 0;
-	if (inter.getMaterial().refracts()) {
-		l = inter.getMaterial().getLocalRefectivity();
-		r = inter.getMaterial().getReflectivity(cosI);
+	l = 0;
+	r = 0;
+	t = 0;
+	if (material.refracts()) {
+		l = material.getLocalRefectivity();
+		r = material.getReflectivity(cosI);
 		t = 1 - r;
 		r = (1 - l) * r;
 		t = (1 - l) * t;
-	} else if (inter.getMaterial().reflects()) {
-		r = inter.getMaterial().getReflectivity(cosI);
+	} else if (material.reflects()) {
+		r = material.getReflectivity(cosI);
 		l = 1 - r;
 	} else {
 		l = 1;
 	}
-	return localColor * l + reflColor * r + refractionColor * t;
 }
 
 Scene Scene::genTexturedScene() {
@@ -146,7 +437,8 @@ Scene Scene::genTexturedScene() {
 
 	Texture checkerboard = Texture::genCheckerboardTexture(2, 2);
 
-	Texture earth("Earth.png");
+	Texture earth("Earth.png", FilterMode::TRILINEAR);
+	earth.setTexelLayout(TexelLayout::TILED, TexelFormat::RGBA32F);
 	Texture hpcLight("logo-light.png");
 	Texture hpcDark("logo-dark.png");
 
@@ -195,3 +487,11 @@ Scene Scene::genTexturedScene() {
 void Scene::setDebug(bool debug) {
 	this->debug = debug;
 }
+
+void Scene::setRayTermination(const RayTermination& termination) {
+	this->termination = termination;
+}
+
+RayTermination Scene::getRayTermination() const {
+	return termination;
+}
@@ -1,17 +1,63 @@
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <Vec3.h>
 #include <vector>
 #include "IntersectableObject.h"
 #include "LightSource.h"
 
+/// <summary>
+/// Ray of a wavefront: sample is the index of the camera ray whose color it
+/// contributes to, weight the product of all reflection and refraction
+/// weights along its path and IOR the optical density of the medium it
+/// travels in.
+/// </summary>
+struct WavefrontRay
+{
+	Ray ray;
+	Vec3 weight;
+	float IOR;
+	uint32_t sample;
+};
+
+/// <summary>
+/// Early termination of reflected and refracted rays. A ray whose
+/// contribution to its pixel (the product of all reflection and refraction
+/// weights along its path) drops below threshold is not traced any further.
+/// With russianRoulette it survives with a probability proportional to its
+/// contribution instead and its color is scaled by the inverse of that
+/// probability, which keeps the expected pixel color unchanged.
+/// </summary>
+struct RayTermination
+{
+	bool enabled = false;
+	float threshold = 1.0f / 255.0f;
+	bool russianRoulette = true;
+};
+
+/// <summary>
+/// Reflected and refracted rays spawned at one bounce (0 are the rays
+/// spawned at the hits of the camera rays), how many of them were
+/// terminated and how many survived the russian roulette. Rays spawned once
+/// the recursion depth is used up are not counted, they are never traced.
+/// </summary>
+struct BounceStats
+{
+	uint64_t spawned = 0;
+	uint64_t terminated = 0;
+	uint64_t survived = 0;
+};
+
 class Scene
 {
 	static constexpr float OFFSET_EPSILON = 0.00001f;
 	std::vector<std::shared_ptr<const IntersectableObject>> sceneObjects;
+	std::vector<uint32_t> objectMaterials;	// material ID of every scene object
+	std::vector<Material> materials;
 	std::vector<std::shared_ptr<const LightSource>> lightSources;
 	Vec3 backgroundColor;
 	bool debug;
+	RayTermination termination;
 
 public:
 	Scene()
@@ -25,11 +71,46 @@ public:
 	void addObject(std::shared_ptr<const IntersectableObject> object);
 	void addLight(std::shared_ptr<const LightSource> ls);
 	Vec3 getBackgroundcolor() const;
+
+	/// <summary>
+	/// Material table, addObject appends the material of every object and
+	/// intersections refer to it by index.
+	/// </summary>
+	const Material& getMaterial(uint32_t materialID) const;
+	size_t getMaterialCount() const;
+
 	std::optional<Intersection> intersect(const Ray& ray, bool shadowRay) const;
 	Vec3 traceRay(const Ray& ray, float IOR, int recDepth) const;
 
+	/// <summary>
+	/// Same as above, the rays spawned at every bounce are counted in stats
+	/// if it is not null, it grows to the number of bounces as needed.
+	/// </summary>
+	Vec3 traceRay(const Ray& ray, float IOR, int recDepth, std::vector<BounceStats>* stats) const;
+
+	/// <summary>
+	/// Iterative version of traceRay for many camera rays at once, colors
+	/// receives one color per ray. Instead of recursing, all rays of one
+	/// bounce are intersected together, optionally shaded in the order of
+	/// their materials, and the reflected and refracted rays they spawn form
+	/// the wavefront of the next bounce.
+	/// </summary>
+	void traceWavefront(const std::vector<Ray>& rays, int recDepth, bool sortByMaterial, std::vector<Vec3>& colors,
+	                    std::vector<BounceStats>* stats = nullptr) const;
+
 	static Scene genTexturedScene();
 
 	void setDebug(bool debug);
+	void setRayTermination(const RayTermination& termination);
+	RayTermination getRayTermination() const;
+
+private:
+	Vec3 traceRay(const Ray& ray, float IOR, int recDepth, int bounce, float contribution, std::vector<BounceStats>* stats) const;
+	float survivalWeight(const Ray& ray, float contribution, int bounce, std::vector<BounceStats>* stats) const;
+	std::optional<TextureDifferentials> texDifferentials(const Ray& ray, const IntersectableObject& object, const TextureCoordinates& texCoords) const;
+	std::optional<RayDifferentials> bendDifferentials(const Ray& ray, const Intersection& inter, const std::optional<float>& IOR) const;
+	std::optional<Ray> refractedRay(const Ray& ray, const Intersection& inter, const Material& material, float IOR, float& refrIOR) const;
+	Vec3 shadeLocal(const Ray& ray, const Intersection& inter, const Material& material, const Vec3& offSurfacePos) const;
+	void computeWeights(const Ray& ray, const Intersection& inter, const Material& material, float& l, float& r, float& t) const;
 
 };
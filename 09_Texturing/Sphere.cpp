@@ -46,7 +46,7 @@ std::optional<Intersection> Sphere::intersect(const Ray& ray) const {
   if (t < 0) t = tCenter + dist;  // when inside sphere
 
   const Vec3 normal = Vec3::normalize(ray.getPosOnRay(t) - center);
-  if (!material.hasTexture()) return Intersection{material, normal, {}, t };
+  if (!material.hasTexture()) return Intersection{normal, {}, t };
 
   Vec3 r = normal;
   // TODO Task01: Complete texture coordinate computation for a sphere
@@ -55,5 +55,5 @@ std::optional<Intersection> Sphere::intersect(const Ray& ray) const {
   // Then compute the normalized texture coordinates u,v.
   // In a last step scale and offset the coordinates by the given values.
 
-  return Intersection{material, normal, {}, t };
+  return Intersection{normal, {}, t };
 }
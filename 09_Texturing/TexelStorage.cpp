@@ -0,0 +1,66 @@
+#include "TexelStorage.h"
+
+TexelStorage::TexelStorage(const Image& image, TexelFormat format) :
+width(image.width),
+height(image.height),
+tilesX((image.width + TILE_SIZE - 1) / TILE_SIZE),
+format(format)
+{
+  const size_t tileCount = size_t(tilesX) * ((height + TILE_SIZE - 1) / TILE_SIZE);
+  if (format == TexelFormat::RGBA8)
+    packedTiles.resize(tileCount, PackedTile{});
+  else
+    floatTiles.resize(tileCount, FloatTile{});
+
+  // images with fewer than three components are expanded to gray values
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      uint8_t rgba[4] = { 0, 0, 0, 255 };
+      for (uint8_t c = 0; c < 4; ++c) {
+        if (c < image.componentCount)
+          rgba[c] = image.getValue(x, y, c);
+        else if (c < 3)
+          rgba[c] = rgba[0];
+      }
+
+      if (format == TexelFormat::RGBA8) {
+        packedTiles[tileIndex(x, y)].texels[texelIndex(x, y)] =
+          uint32_t(rgba[0]) | uint32_t(rgba[1]) << 8 | uint32_t(rgba[2]) << 16 | uint32_t(rgba[3]) << 24;
+      } else {
+        float* texel = floatTiles[tileIndex(x, y)].texels[texelIndex(x, y)];
+        for (uint8_t c = 0; c < 4; ++c)
+          texel[c] = rgba[c] / 255.0f;
+      }
+    }
+  }
+}
+
+static Vec3 unpack(uint32_t texel) {
+  return { (texel & 0xFF) / 255.0f, ((texel >> 8) & 0xFF) / 255.0f, ((texel >> 16) & 0xFF) / 255.0f };
+}
+
+Vec3 TexelStorage::fetch(uint32_t x, uint32_t y) const {
+  if (format == TexelFormat::RGBA8)
+    return unpack(packedTiles[tileIndex(x, y)].texels[texelIndex(x, y)]);
+
+  const float* texel = floatTiles[tileIndex(x, y)].texels[texelIndex(x, y)];
+  return { texel[0], texel[1], texel[2] };
+}
+
+void TexelStorage::fetchQuad(uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1, Vec3 texels[4]) const {
+  if (format == TexelFormat::RGBA8) {
+    texels[0] = unpack(packedTiles[tileIndex(x0, y0)].texels[texelIndex(x0, y0)]);
+    texels[1] = unpack(packedTiles[tileIndex(x1, y0)].texels[texelIndex(x1, y0)]);
+    texels[2] = unpack(packedTiles[tileIndex(x0, y1)].texels[texelIndex(x0, y1)]);
+    texels[3] = unpack(packedTiles[tileIndex(x1, y1)].texels[texelIndex(x1, y1)]);
+  } else {
+    texels[0] = fetch(x0, y0);
+    texels[1] = fetch(x1, y0);
+    texels[2] = fetch(x0, y1);
+    texels[3] = fetch(x1, y1);
+  }
+}
+
+size_t TexelStorage::getByteSize() const {
+  return packedTiles.size() * sizeof(PackedTile) + floatTiles.size() * sizeof(FloatTile);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Image.h"
+#include "Vec3.h"
+
+/// <summary>
+/// ROW_MAJOR reads the texels from the Image of the texture, TILED copies
+/// them into TexelStorage.
+/// </summary>
+enum class TexelLayout {
+	ROW_MAJOR, TILED
+};
+
+/// <summary>
+/// RGBA8 keeps the 8 bit values and packs the components of a texel into one
+/// 32 bit word, RGBA32F converts them to floats in [0;1] once when the
+/// storage is built.
+/// </summary>
+enum class TexelFormat {
+	RGBA8, RGBA32F
+};
+
+/// <summary>
+/// Copy of one texture level in which the texels are swizzled into 4x4
+/// tiles stored one after the other, row by row. A tile of RGBA8 texels
+/// fills exactly one 64 byte cache line and a tile row of RGBA32F texels
+/// one as well, so the four taps of a bilinear lookup touch one or two
+/// cache lines unless they straddle a tile border, where the row-major
+/// layout touches two lines that lie a whole image row apart.
+/// </summary>
+class TexelStorage {
+public:
+	static constexpr uint32_t TILE_SIZE = 4;
+
+	TexelStorage(const Image& image, TexelFormat format);
+
+	Vec3 fetch(uint32_t x, uint32_t y) const;
+
+	/// <summary>
+	/// Fetches the texels (x0, y0), (x1, y0), (x0, y1) and (x1, y1) in this
+	/// order. The coordinates have to be inside the level, border handling
+	/// is done by the caller.
+	/// </summary>
+	void fetchQuad(uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1, Vec3 texels[4]) const;
+
+	uint32_t getWidth() const { return width; }
+	uint32_t getHeight() const { return height; }
+	TexelFormat getFormat() const { return format; }
+	size_t getByteSize() const;
+
+private:
+	struct alignas(64) PackedTile {
+		uint32_t texels[TILE_SIZE * TILE_SIZE];
+	};
+
+	struct alignas(64) FloatTile {
+		float texels[TILE_SIZE * TILE_SIZE][4];
+	};
+
+	uint32_t width;
+	uint32_t height;
+	uint32_t tilesX;
+	TexelFormat format;
+	std::vector<PackedTile> packedTiles;
+	std::vector<FloatTile> floatTiles;
+
+	size_t tileIndex(uint32_t x, uint32_t y) const {
+		return size_t(y / TILE_SIZE) * tilesX + x / TILE_SIZE;
+	}
+
+	static uint32_t texelIndex(uint32_t x, uint32_t y) {
+		return (y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE;
+	}
+};
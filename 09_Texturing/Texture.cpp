@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <utility>
+#include <vector>
 
 #include "Texture.h"
-#include <stb_image.h>
+#include "TextureCache.h"
 
 Texture::Texture(uint32_t width, uint32_t height) :
 Texture(width, height, FilterMode::BILINEAR)
@@ -38,31 +41,37 @@ Texture(filename, filterMode, BorderMode::REPEAT)
 
 Texture::Texture(const std::string& filename, FilterMode filterMode,
                  BorderMode borderMode) :
+width(0),
+height(0),
 filterMode(filterMode),
 borderModeU(borderMode),
 borderModeV(borderMode),
 borderColor(Vec3{0,0,0})
 {
-  stbi_set_flip_vertically_on_load(false);
-
-  int width, height, nrComponents;
-  stbi_uc* image_data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-  if(image_data) {
-    this->width = uint32_t(width);
-    this->height = uint32_t(height);
-    this->borderModeU = borderMode;
-    this->borderModeV = borderMode;
-    this->filterMode = filterMode;
-
-    data = std::make_unique<Image>(width, height, nrComponents, std::vector<uint8_t>{image_data, image_data + (width * height * nrComponents) });
-
-    stbi_image_free(image_data);
-  } else {
-    std::cerr << "Texture failed to load at path: " << filename << std::endl;
-    stbi_image_free(image_data);
+  // files are decoded once, every further texture of the same file shares
+  // the image and the pyramid
+  const std::shared_ptr<const TextureData> cached = TextureCache::instance().load(filename);
+  if(cached) {
+    this->width = cached->image->width;
+    this->height = cached->image->height;
+    this->filename = filename;
+    data = cached->image;
+    mipLevels = cached->mipLevels;
   }
 }
 
+Texture::Texture(const Image& image, FilterMode filterMode, BorderMode borderMode) :
+width(image.width),
+height(image.height),
+filterMode(filterMode),
+borderModeU(borderMode),
+borderModeV(borderMode),
+borderColor(Vec3{0,0,0})
+{
+  data = std::make_unique<Image>(image);
+  generateMipmaps();
+}
+
 Texture Texture::genCheckerboardTexture(uint32_t width, uint32_t height) {
   Texture checkerboard(width, height, FilterMode::NEAREST, BorderMode::REPEAT);
 
@@ -77,9 +86,102 @@ Texture Texture::genCheckerboardTexture(uint32_t width, uint32_t height) {
     }
   }
 
+  checkerboard.generateMipmaps();
   return checkerboard;
 }
 
+/// <summary>
+/// Source texels covered by each texel of the next smaller level together
+/// with the covered fraction. For even sizes these are two texels with
+/// weight 1/2, for odd sizes the footprints overlap partially, so that every
+/// source texel contributes with its full area and the mean color is kept.
+/// </summary>
+static std::vector<std::vector<std::pair<uint32_t, float>>> downsampleWeights(uint32_t size, uint32_t newSize) {
+  std::vector<std::vector<std::pair<uint32_t, float>>> weights(newSize);
+  const float scale = float(size) / float(newSize);
+  for (uint32_t i = 0; i < newSize; ++i) {
+    const float begin = i * scale;
+    const float end = (i + 1) * scale;
+    for (uint32_t j = uint32_t(begin); j < size && float(j) < end; ++j) {
+      const float overlap = std::min(end, float(j + 1)) - std::max(begin, float(j));
+      if (overlap > 0.0f)
+        weights[i].push_back({ j, overlap / scale });
+    }
+  }
+  return weights;
+}
+
+std::shared_ptr<const std::vector<Image>> Texture::createMipLevels(const Image& image) {
+  std::vector<Image> levels;
+  const Image* previous = &image;
+  while (previous->width > 1 || previous->height > 1) {
+    const uint32_t levelWidth = std::max(1u, previous->width / 2);
+    const uint32_t levelHeight = std::max(1u, previous->height / 2);
+    const auto weightsX = downsampleWeights(previous->width, levelWidth);
+    const auto weightsY = downsampleWeights(previous->height, levelHeight);
+
+    Image level(levelWidth, levelHeight, previous->componentCount);
+    for (uint32_t y = 0; y < levelHeight; ++y) {
+      for (uint32_t x = 0; x < levelWidth; ++x) {
+        for (uint8_t c = 0; c < previous->componentCount; ++c) {
+          float sum = 0.0f;
+          for (const auto& [sy, wy] : weightsY[y])
+            for (const auto& [sx, wx] : weightsX[x])
+              sum += previous->getValue(sx, sy, c) * wx * wy;
+          level.setValue(x, y, c, uint8_t(std::min(255.0f, sum + 0.5f)));
+        }
+      }
+    }
+    levels.push_back(std::move(level));
+    previous = &levels.back();
+  }
+  return std::make_shared<const std::vector<Image>>(std::move(levels));
+}
+
+void Texture::generateMipmaps() {
+  mipLevels = createMipLevels(*data);
+  if (texelLayout == TexelLayout::TILED)
+    buildTexelStorage();
+}
+
+void Texture::setTexelLayout(TexelLayout layout, TexelFormat format) {
+  texelLayout = layout;
+  texelFormat = format;
+  if (texelLayout == TexelLayout::TILED)
+    buildTexelStorage();
+  else
+    texels.reset();
+}
+
+std::shared_ptr<const std::vector<TexelStorage>> Texture::createTexelStorage(const Image& image,
+                                                                            const std::vector<Image>& mipLevels,
+                                                                            TexelFormat format) {
+  std::vector<TexelStorage> levels;
+  levels.emplace_back(image, format);
+  for (const Image& level : mipLevels)
+    levels.emplace_back(level, format);
+  return std::make_shared<const std::vector<TexelStorage>>(std::move(levels));
+}
+
+void Texture::buildTexelStorage() {
+  if (!filename.empty()) {
+    const std::shared_ptr<const TextureData> cached = TextureCache::instance().load(filename, texelLayout, texelFormat);
+    if (cached) {
+      texels = cached->texels;
+      return;
+    }
+  }
+  texels = createTexelStorage(*data, mipLevels ? *mipLevels : std::vector<Image>{}, texelFormat);
+}
+
+size_t Texture::getMipLevelCount() const {
+  return 1 + (mipLevels ? mipLevels->size() : 0);
+}
+
+const Image& Texture::getMipLevel(size_t level) const {
+  return level == 0 ? *data : (*mipLevels)[level - 1];
+}
+
 static uint32_t handleBorderCoordinate(int pixelCoord, uint32_t max,
                                        BorderMode bordermode) {
   // TODO Task03: Implement the missing bordermodes CLAMP_TO_BORDER, CLAMP_TO_EDGE, MIRRORED_REPEAT.
@@ -99,12 +201,101 @@ Vec3 Texture::sample(int pixelCoordX, int pixelCoordY) const {
   const uint32_t sampleCoordX = handleBorderCoordinate(pixelCoordX, width, borderModeU);
   const uint32_t sampleCoordY = handleBorderCoordinate(pixelCoordY, height, borderModeV);
 
+  if (texels)
+    return (*texels)[0].fetch(sampleCoordX, sampleCoordY);
+
   return {data->getValue(sampleCoordX, sampleCoordY, 0) / 255.0f,
     data->getValue(sampleCoordX, sampleCoordY, 1) / 255.0f,
     data->getValue(sampleCoordX, sampleCoordY, 2) / 255.0f};
 }
 
 
+Vec3 Texture::texel(const Image& level, uint32_t x, uint32_t y) const {
+  return {level.getValue(x, y, 0) / 255.0f,
+    level.getValue(x, y, 1) / 255.0f,
+    level.getValue(x, y, 2) / 255.0f};
+}
+
+/// <summary>
+/// Bilinear lookup in one mip level, texel centers lie at (i + 0.5) / size
+/// so that every texel of a level sits in the middle of the 2x2 texels it
+/// was averaged from.
+/// </summary>
+Vec3 Texture::sampleBilinear(size_t level, const TextureCoordinates& texCoords) const {
+  const Image& image = getMipLevel(level);
+  const float dx = texCoords.u * image.width - 0.5f;
+  const float dy = texCoords.v * image.height - 0.5f;
+  const float fx = std::floor(dx);
+  const float fy = std::floor(dy);
+  const int x = int(fx);
+  const int y = int(fy);
+  const float alpha = dx - fx;
+  const float beta = dy - fy;
+
+  const uint32_t x0 = handleBorderCoordinate(x, image.width, borderModeU);
+  const uint32_t x1 = handleBorderCoordinate(x + 1, image.width, borderModeU);
+  const uint32_t y0 = handleBorderCoordinate(y, image.height, borderModeV);
+  const uint32_t y1 = handleBorderCoordinate(y + 1, image.height, borderModeV);
+
+  Vec3 taps[4];
+  if (texels) {
+    (*texels)[level].fetchQuad(x0, x1, y0, y1, taps);
+  } else {
+    taps[0] = texel(image, x0, y0);
+    taps[1] = texel(image, x1, y0);
+    taps[2] = texel(image, x0, y1);
+    taps[3] = texel(image, x1, y1);
+  }
+
+  const Vec3 bottom = taps[0] * (1.0f - alpha) + taps[1] * alpha;
+  const Vec3 top = taps[2] * (1.0f - alpha) + taps[3] * alpha;
+  return bottom * (1.0f - beta) + top * beta;
+}
+
+Vec3 Texture::sample(const TextureCoordinates& texCoords,
+                     const std::optional<TextureDifferentials>& differentials) const {
+  if (filterMode != FilterMode::TRILINEAR)
+    return sample(texCoords);
+
+  if (!differentials.has_value())
+    return sampleBilinear(0, texCoords);
+
+  // footprint of the sample in texels of level 0, the longer differential is
+  // the major axis. Up to MAX_ANISOTROPY taps are spread along the major axis,
+  // each filtering only as much as the minor axis requires, so surfaces at
+  // grazing angles are not blurred across the whole footprint.
+  const float majorU[2] = { differentials->dx.u, differentials->dy.u };
+  const float majorV[2] = { differentials->dx.v, differentials->dy.v };
+  const float lengthX = std::hypot(majorU[0] * width, majorV[0] * height);
+  const float lengthY = std::hypot(majorU[1] * width, majorV[1] * height);
+  const int major = lengthX >= lengthY ? 0 : 1;
+  const float majorLength = std::max(lengthX, lengthY);
+  const float minorLength = std::min(lengthX, lengthY);
+
+  int taps = 1;
+  if (minorLength > 0.0f)
+    taps = int(std::ceil(std::min(majorLength / minorLength, float(MAX_ANISOTROPY))));
+  const float footprint = majorLength / float(taps);
+
+  float lod = 0.0f;
+  if (footprint > 1.0f)
+    lod = std::min(std::log2(footprint), float(getMipLevelCount() - 1));
+  const size_t level = size_t(lod);
+  const float blend = lod - float(level);
+
+  Vec3 color{ 0.0f, 0.0f, 0.0f };
+  for (int i = 0; i < taps; ++i) {
+    // tap positions are centered on the sample and cover one differential
+    const float offset = (i + 0.5f) / float(taps) - 0.5f;
+    const TextureCoordinates tap{ texCoords.u + majorU[major] * offset, texCoords.v + majorV[major] * offset };
+    Vec3 tapColor = sampleBilinear(level, tap);
+    if (blend > 0.0f)
+      tapColor = tapColor * (1.0f - blend) + sampleBilinear(level + 1, tap) * blend;
+    color = color + tapColor;
+  }
+  return color / float(taps);
+}
+
 Vec3 Texture::sample(const TextureCoordinates& texCoords) const {
   const float dx = texCoords.u * width;
   const float dy = texCoords.v * height;
@@ -119,6 +310,8 @@ Vec3 Texture::sample(const TextureCoordinates& texCoords) const {
       // TODO Task03: Implement sampling using Bilinear Filtering
       return {1.0f, 1.0f, 1.0f};
     }
+    case FilterMode::TRILINEAR:
+      return sampleBilinear(0, texCoords);
     default:
       std::cout << "Specified bordermode cannot be handled..." << std::endl;
       return {};
@@ -1,11 +1,20 @@
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <vector>
+
 #include "Image.h"
 #include "Vec3.h"
+#include "TexelStorage.h"
 #include "TextureCoordinates.h"
 
+/// <summary>
+/// TRILINEAR filters bilinearly in the two mip levels closest to the
+/// footprint of the sample and blends between them.
+/// </summary>
 enum class FilterMode {
-	NEAREST, BILINEAR
+	NEAREST, BILINEAR, TRILINEAR
 };
 
 enum class BorderMode {
@@ -13,6 +22,8 @@ enum class BorderMode {
 };
 
 class Texture {
+	static constexpr int MAX_ANISOTROPY = 8;
+
   uint32_t width;
   uint32_t height;
 	FilterMode filterMode;
@@ -20,6 +31,11 @@ class Texture {
 	BorderMode borderModeV;
 	Vec3 borderColor;
 	std::shared_ptr<Image> data{};
+	std::shared_ptr<const std::vector<Image>> mipLevels{};	// levels 1, 2, ... of the pyramid, level 0 is data
+	TexelLayout texelLayout{TexelLayout::ROW_MAJOR};
+	TexelFormat texelFormat{TexelFormat::RGBA8};
+	std::shared_ptr<const std::vector<TexelStorage>> texels{};	// all levels of the pyramid, only for TILED
+	std::string filename{};	// empty for textures created in code, which bypass the TextureCache
 
 public:
 
@@ -29,13 +45,42 @@ public:
 	Texture(const std::string& filename);
 	Texture(const std::string& filename, FilterMode filterMode);
 	Texture(const std::string& filename, FilterMode filterMode, BorderMode borderMode);
+	Texture(const Image& image, FilterMode filterMode, BorderMode borderMode);
 
 	static Texture genCheckerboardTexture(uint32_t width, uint32_t height);
 
+	static std::shared_ptr<const std::vector<Image>> createMipLevels(const Image& image);
+	static std::shared_ptr<const std::vector<TexelStorage>> createTexelStorage(const Image& image, const std::vector<Image>& mipLevels, TexelFormat format);
+
 	Vec3 sample(const TextureCoordinates& texCoords) const;
+
+	/// <summary>
+	/// Same as above, in TRILINEAR mode the mip level is chosen from the
+	/// footprint given by the differentials, without them level 0 is used.
+	/// </summary>
+	Vec3 sample(const TextureCoordinates& texCoords, const std::optional<TextureDifferentials>& differentials) const;
+
+	/// <summary>
+	/// Builds the mip pyramid by averaging 2x2 texels per level. Loading a
+	/// texture from a file does this already, textures filled in code have to
+	/// call it once they are complete.
+	/// </summary>
+	void generateMipmaps();
+	size_t getMipLevelCount() const;
+
+	/// <summary>
+	/// Selects where the texels are read from. TILED keeps a copy of every mip
+	/// level in TexelStorage, which costs memory (four times as much for
+	/// RGBA32F) but keeps the taps of a lookup within one or two cache lines.
+	/// The Image of the texture stays the reference copy in both layouts.
+	/// </summary>
+	void setTexelLayout(TexelLayout layout, TexelFormat format = TexelFormat::RGBA8);
+	TexelLayout getTexelLayout() const { return texelLayout; }
+	TexelFormat getTexelFormat() const { return texelFormat; }
 	
   uint32_t getWidth() const { return width; }
   uint32_t getHeight() const { return height; }
+	FilterMode getFilterMode() const { return filterMode; }
 	void setBorderMode(BorderMode borderMode);
 	void setBorderModeU(BorderMode borderMode);
 	void setBorderModeV(BorderMode borderMode);
@@ -43,5 +88,9 @@ public:
 
 private:
 	Vec3 sample(int pixelCoordX, int pixelCoordY) const;
+	const Image& getMipLevel(size_t level) const;
+	void buildTexelStorage();
+	Vec3 texel(const Image& level, uint32_t x, uint32_t y) const;
+	Vec3 sampleBilinear(size_t level, const TextureCoordinates& texCoords) const;
 };
 
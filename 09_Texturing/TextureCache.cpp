@@ -0,0 +1,156 @@
+#include <iostream>
+
+#include "TextureCache.h"
+#include "Texture.h"
+#include <stb_image.h>
+
+TextureCache& TextureCache::instance() {
+  static TextureCache cache;
+  return cache;
+}
+
+std::shared_ptr<const TextureData> TextureCache::load(const std::string& filename,
+                                                      TexelLayout layout, TexelFormat format) {
+  const std::shared_ptr<const TextureData> source = lookup(Key{ filename, TexelLayout::ROW_MAJOR, TexelFormat::RGBA8 }, nullptr);
+  if (!source || layout != TexelLayout::TILED)
+    return source;
+
+  // the TILED entry only holds the texels, the image and the pyramid are
+  // those of the row-major entry, so every byte is counted exactly once
+  const std::shared_ptr<const TextureData> tiled = lookup(Key{ filename, layout, format }, source.get());
+  if (!tiled)
+    return nullptr;
+  TextureData data = *source;
+  data.texels = tiled->texels;
+  return std::make_shared<const TextureData>(std::move(data));
+}
+
+std::shared_ptr<const TextureData> TextureCache::lookup(const Key& key, const TextureData* source) {
+  std::unique_lock<std::mutex> lock(mutex);
+  auto it = entries.find(key);
+  if (it != entries.end()) {
+    ++stats.hits;
+    recentlyUsed.splice(recentlyUsed.begin(), recentlyUsed, it->second.position);
+    const Data data = it->second.data;
+    lock.unlock();
+    // waits if another thread is still decoding this key
+    return data.get();
+  }
+
+  ++stats.misses;
+  std::promise<std::shared_ptr<const TextureData>> promise;
+  Entry& entry = entries[key];
+  entry.data = promise.get_future().share();
+  recentlyUsed.push_front(key);
+  entry.position = recentlyUsed.begin();
+  lock.unlock();
+
+  // the entry stays in the cache while it is decoded (neither clear nor
+  // evict remove entries without bytes), so it can be looked up again below
+  std::shared_ptr<const TextureData> data;
+  try {
+    data = create(key, source);
+  } catch (...) {
+    // the waiting threads get the same exception, and like any other
+    // failure it is not cached
+    promise.set_exception(std::current_exception());
+    lock.lock();
+    it = entries.find(key);
+    recentlyUsed.erase(it->second.position);
+    entries.erase(it);
+    throw;
+  }
+  promise.set_value(data);
+
+  lock.lock();
+  it = entries.find(key);
+  if (!data) {
+    recentlyUsed.erase(it->second.position);
+    entries.erase(it);
+    return data;
+  }
+
+  size_t bytes = 0;
+  if (std::get<1>(key) == TexelLayout::TILED) {
+    for (const TexelStorage& level : *data->texels)
+      bytes += level.getByteSize();
+  } else {
+    bytes = data->image->data.size();
+    for (const Image& level : *data->mipLevels)
+      bytes += level.data.size();
+  }
+  it->second.bytes = bytes;
+  stats.bytes += bytes;
+  evict();
+  return data;
+}
+
+std::shared_ptr<const TextureData> TextureCache::create(const Key& key, const TextureData* source) {
+  const auto& [filename, layout, format] = key;
+
+  if (layout == TexelLayout::TILED) {
+    TextureData data;
+    data.texels = Texture::createTexelStorage(*source->image, *source->mipLevels, format);
+    return std::make_shared<const TextureData>(std::move(data));
+  }
+
+  stbi_set_flip_vertically_on_load_thread(false);
+
+  int width, height, nrComponents;
+  stbi_uc* image_data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+  if (!image_data) {
+    std::cerr << "Texture failed to load at path: " << filename << std::endl;
+    return nullptr;
+  }
+
+  TextureData data;
+  data.image = std::make_shared<Image>(width, height, nrComponents, std::vector<uint8_t>{image_data, image_data + (width * height * nrComponents) });
+  stbi_image_free(image_data);
+  data.mipLevels = Texture::createMipLevels(*data.image);
+  return std::make_shared<const TextureData>(std::move(data));
+}
+
+void TextureCache::evict() {
+  auto position = recentlyUsed.end();
+  while (stats.bytes > memoryBudget && position != recentlyUsed.begin()) {
+    --position;
+    auto it = entries.find(*position);
+    if (it->second.bytes == 0)
+      continue;
+    stats.bytes -= it->second.bytes;
+    ++stats.evictions;
+    position = recentlyUsed.erase(position);
+    entries.erase(it);
+  }
+}
+
+void TextureCache::setMemoryBudget(size_t bytes) {
+  std::scoped_lock<std::mutex> lock(mutex);
+  memoryBudget = bytes;
+  evict();
+}
+
+size_t TextureCache::getMemoryBudget() const {
+  std::scoped_lock<std::mutex> lock(mutex);
+  return memoryBudget;
+}
+
+TextureCacheStats TextureCache::getStats() const {
+  std::scoped_lock<std::mutex> lock(mutex);
+  TextureCacheStats result = stats;
+  result.entries = entries.size();
+  return result;
+}
+
+void TextureCache::clear() {
+  std::scoped_lock<std::mutex> lock(mutex);
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->second.bytes == 0) {
+      ++it;
+      continue;
+    }
+    stats.bytes -= it->second.bytes;
+    recentlyUsed.erase(it->second.position);
+    it = entries.erase(it);
+  }
+}
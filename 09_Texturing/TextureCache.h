@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "Image.h"
+#include "TexelStorage.h"
+
+/// <summary>
+/// Decoded texture file with its mip pyramid and, for the TILED layout, the
+/// swizzled copy of all levels. In the cache the row-major entry of a file
+/// holds the Image and the pyramid and its TILED entries hold only their
+/// texels, load returns them combined.
+/// </summary>
+struct TextureData
+{
+	std::shared_ptr<Image> image;
+	std::shared_ptr<const std::vector<Image>> mipLevels;
+	std::shared_ptr<const std::vector<TexelStorage>> texels;
+};
+
+struct TextureCacheStats
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t evictions = 0;
+	size_t entries = 0;
+	size_t bytes = 0;
+};
+
+/// <summary>
+/// Process-wide cache of decoded texture files, keyed by path, texel layout
+/// and texel format, so that every file is decoded only once no matter how
+/// many textures are created from it. Least recently used entries are
+/// dropped once the cache holds more than the memory budget, textures that
+/// still use them keep their data alive. load may be called from several
+/// threads, concurrent loads of the same key wait for a single decode.
+/// </summary>
+class TextureCache
+{
+public:
+	static TextureCache& instance();
+
+	/// <summary>
+	/// Returns the data of the file, decoding it on a miss. Returns nullptr
+	/// if the file cannot be loaded, failures are not cached. Exceptions
+	/// thrown while decoding, e.g. std::bad_alloc, reach every thread that
+	/// waits for the same key.
+	/// </summary>
+	std::shared_ptr<const TextureData> load(const std::string& filename,
+	                                        TexelLayout layout = TexelLayout::ROW_MAJOR,
+	                                        TexelFormat format = TexelFormat::RGBA8);
+
+	void setMemoryBudget(size_t bytes);
+	size_t getMemoryBudget() const;
+	TextureCacheStats getStats() const;
+	void clear();
+
+private:
+	using Key = std::tuple<std::string, TexelLayout, TexelFormat>;
+	using Data = std::shared_future<std::shared_ptr<const TextureData>>;
+
+	struct Entry
+	{
+		Data data;
+		size_t bytes = 0;	// 0 while the entry is being decoded
+		std::list<Key>::iterator position;
+	};
+
+	mutable std::mutex mutex;
+	std::map<Key, Entry> entries;
+	std::list<Key> recentlyUsed;	// most recently used first
+	size_t memoryBudget = size_t(512) << 20;
+	TextureCacheStats stats;
+
+	TextureCache() = default;
+
+	// source is the row-major data of the file, TILED entries are created from it
+	std::shared_ptr<const TextureData> lookup(const Key& key, const TextureData* source);
+	std::shared_ptr<const TextureData> create(const Key& key, const TextureData* source);
+	void evict();
+};
@@ -8,4 +8,13 @@ struct TextureCoordinates
 	TextureCoordinates(float u, float v)
 		: u(u), v(v)
 	{}
-};
\ No newline at end of file
+};
+/// <summary>
+/// Change of the texture coordinates from one sample to the next in x and y
+/// direction on the image plane.
+/// </summary>
+struct TextureDifferentials
+{
+	TextureCoordinates dx;
+	TextureCoordinates dy;
+};
@@ -0,0 +1,254 @@
+#include <Image.h>
+#include <png.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+#include "Raytracer.h"
+#include "Scene.h"
+#include "TextureCache.h"
+
+// Headless renderer for render nodes and regression tracking: renders the
+// textured scene without opening a window, saves the image as PNG and
+// writes the timings of every phase as JSON. The textures are loaded from
+// the working directory.
+
+struct BatchSettings
+{
+	uint32_t width = 600;
+	uint32_t height = 600;
+	int samples = 9;
+	int depth = 5;
+	uint32_t repeat = 1;
+	bool wavefront = false;
+	bool sortByMaterial = true;
+	RayTermination termination;
+	std::string output = "render.png";
+	std::string report = "report.json";
+};
+
+struct PhaseTimings
+{
+	double sceneMilliseconds = 0.0;
+	std::vector<double> renderMilliseconds;
+	double saveMilliseconds = 0.0;
+	double wallMilliseconds = 0.0;
+};
+
+
+static void printUsage()
+{
+	std::cerr << "usage: texturing-batch [options]\n"
+		<< "  --width N         image width (600)\n"
+		<< "  --height N        image height (600)\n"
+		<< "  --samples N       samples per pixel (9)\n"
+		<< "  --depth N         recursion depth (5)\n"
+		<< "  --repeat N        number of timed renders (1)\n"
+		<< "  --wavefront       trace the camera rays in wavefronts instead of recursively\n"
+		<< "  --unsorted        do not sort the wavefronts by material\n"
+		<< "  --termination     terminate rays that hardly contribute to their pixel\n"
+		<< "  --threshold F     contribution below which rays are terminated (0.0039)\n"
+		<< "  --no-roulette     terminate all rays below the threshold instead of playing russian roulette\n"
+		<< "  --output FILE     PNG image (render.png)\n"
+		<< "  --report FILE     JSON report (report.json)\n";
+}
+
+static bool parseArguments(const std::vector<std::string>& args, BatchSettings& settings)
+{
+	try
+	{
+		for (size_t i = 0; i < args.size(); ++i)
+		{
+			const std::string& arg = args[i];
+			auto value = [&]() -> const std::string& {
+				if (i + 1 >= args.size())
+					throw std::invalid_argument("missing value for " + arg);
+				return args[++i];
+			};
+
+			if (arg == "--width") settings.width = uint32_t(std::stoul(value()));
+			else if (arg == "--height") settings.height = uint32_t(std::stoul(value()));
+			else if (arg == "--samples") settings.samples = std::stoi(value());
+			else if (arg == "--depth") settings.depth = std::stoi(value());
+			else if (arg == "--repeat") settings.repeat = uint32_t(std::stoul(value()));
+			else if (arg == "--wavefront") settings.wavefront = true;
+			else if (arg == "--unsorted") settings.sortByMaterial = false;
+			else if (arg == "--termination") settings.termination.enabled = true;
+			else if (arg == "--threshold") settings.termination.threshold = std::stof(value());
+			else if (arg == "--no-roulette") settings.termination.russianRoulette = false;
+			else if (arg == "--output") settings.output = value();
+			else if (arg == "--report") settings.report = value();
+			else throw std::invalid_argument("unknown option " + arg);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << "\n";
+		return false;
+	}
+
+	if (settings.width == 0 || settings.height == 0 || settings.samples < 1 || settings.repeat == 0)
+	{
+		std::cerr << "width, height, samples and repeat must be positive\n";
+		return false;
+	}
+	return true;
+}
+
+static double millisecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+	return duration.count();
+}
+
+static std::string escapeJSON(const std::string& text)
+{
+	std::string escaped;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\')
+		{
+			escaped += '\\';
+			escaped += c;
+		}
+		else if (uint8_t(c) < 0x20)
+		{
+			const char* digits = "0123456789abcdef";
+			escaped += "\\u00";
+			escaped += digits[uint8_t(c) >> 4];
+			escaped += digits[uint8_t(c) & 15];
+		}
+		else
+		{
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+static void writeReport(std::ostream& os, const BatchSettings& settings, const std::vector<BounceStats>& bounces,
+                        const TextureCacheStats& cacheStats, const PhaseTimings& timings)
+{
+	const std::vector<double>& renders = timings.renderMilliseconds;
+	const double bestRender = *std::min_element(renders.begin(), renders.end());
+	double meanRender = 0.0;
+	for (double ms : renders)
+		meanRender += ms;
+	meanRender /= double(renders.size());
+
+	// the Raytracer rounds the samples to a grid of numSamplesX x numSamplesY
+	const int samplesX = int(std::sqrt(float(settings.samples)));
+	const int samplesY = settings.samples / samplesX;
+	const double primaryRays = double(samplesX * samplesY) * double(settings.width) * double(settings.height);
+
+	// rays/sec counts camera rays and the reflected and refracted rays that
+	// were traced, shadow rays are not tracked
+	double secondaryRays = 0.0;
+	for (const BounceStats& bounce : bounces)
+		secondaryRays += double(bounce.spawned - bounce.terminated);
+
+	os << std::fixed << std::setprecision(3);
+	os << "{\n"
+		<< "  \"scene\": \"textured\",\n"
+		<< "  \"output\": \"" << escapeJSON(settings.output) << "\",\n"
+		<< "  \"width\": " << settings.width << ",\n"
+		<< "  \"height\": " << settings.height << ",\n"
+		<< "  \"samples\": " << samplesX * samplesY << ",\n"
+		<< "  \"depth\": " << settings.depth << ",\n"
+		<< "  \"wavefront\": " << (settings.wavefront ? "true" : "false") << ",\n"
+		<< "  \"sortByMaterial\": " << (settings.sortByMaterial ? "true" : "false") << ",\n"
+		<< "  \"termination\": { \"enabled\": " << (settings.termination.enabled ? "true" : "false")
+		<< ", \"threshold\": " << std::setprecision(5) << settings.termination.threshold << std::setprecision(3)
+		<< ", \"russianRoulette\": " << (settings.termination.russianRoulette ? "true" : "false") << " },\n"
+		<< "  \"phasesMilliseconds\": {\n"
+		<< "    \"scene\": " << timings.sceneMilliseconds << ",\n"
+		<< "    \"render\": " << bestRender << ",\n"
+		<< "    \"save\": " << timings.saveMilliseconds << "\n"
+		<< "  },\n"
+		<< "  \"renderMilliseconds\": [";
+	for (size_t i = 0; i < renders.size(); ++i)
+		os << (i ? ", " : "") << renders[i];
+	os << "],\n"
+		<< "  \"meanRenderMilliseconds\": " << meanRender << ",\n"
+		<< "  \"wallMilliseconds\": " << timings.wallMilliseconds << ",\n"
+		<< std::setprecision(0)
+		<< "  \"primaryRays\": " << primaryRays << ",\n"
+		<< "  \"secondaryRays\": " << secondaryRays << ",\n"
+		<< "  \"raysPerSecond\": " << (primaryRays + secondaryRays) / (bestRender / 1000.0) << ",\n"
+		<< "  \"bounces\": [";
+	for (size_t i = 0; i < bounces.size(); ++i)
+	{
+		os << (i ? ",\n" : "\n") << "    { \"spawned\": " << bounces[i].spawned << ", \"terminated\": "
+			<< bounces[i].terminated << ", \"survived\": " << bounces[i].survived << " }";
+	}
+	os << (bounces.empty() ? "],\n" : "\n  ],\n")
+		<< "  \"textureCache\": { \"hits\": " << cacheStats.hits << ", \"misses\": " << cacheStats.misses
+		<< ", \"entries\": " << cacheStats.entries << ", \"bytes\": " << cacheStats.bytes << " }\n"
+		<< std::setprecision(3)
+		<< "}\n";
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> args{ argv + 1, argv + argc };
+	BatchSettings settings;
+	if (!parseArguments(args, settings))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	PhaseTimings timings;
+	const auto programStart = std::chrono::steady_clock::now();
+
+	// includes decoding the textures and building their mip pyramids
+	auto start = programStart;
+	Scene scene = Scene::genTexturedScene();
+	scene.setRayTermination(settings.termination);
+	timings.sceneMilliseconds = millisecondsSince(start);
+
+	Camera camera;
+	camera.setEyePoint(Vec3{ 0.0, 0.0, 2.0 });
+	camera.setLookAt(Vec3{ 0.0, 0.0, 0.0 });
+
+	Raytracer raytracer(settings.depth, settings.samples);
+	raytracer.setCamera(camera);
+	raytracer.setScene(scene);
+	raytracer.setWavefront(settings.wavefront, settings.sortByMaterial);
+
+	Image image(settings.width, settings.height);
+	for (uint32_t i = 0; i < settings.repeat; ++i)
+	{
+		start = std::chrono::steady_clock::now();
+		raytracer.render(image);
+		timings.renderMilliseconds.push_back(millisecondsSince(start));
+	}
+
+	start = std::chrono::steady_clock::now();
+	if (!PNG::save(settings.output, image))
+	{
+		std::cerr << "could not save " << settings.output << "\n";
+		return EXIT_FAILURE;
+	}
+	timings.saveMilliseconds = millisecondsSince(start);
+	timings.wallMilliseconds = millisecondsSince(programStart);
+
+	const TextureCacheStats cacheStats = TextureCache::instance().getStats();
+	std::ofstream report(settings.report);
+	if (!report)
+	{
+		std::cerr << "could not write " << settings.report << "\n";
+		return EXIT_FAILURE;
+	}
+	writeReport(report, settings, raytracer.getBounceStats(), cacheStats, timings);
+	writeReport(std::cout, settings, raytracer.getBounceStats(), cacheStats, timings);
+	return EXIT_SUCCESS;
+}
@@ -1,10 +1,12 @@
 #include <GLApp.h>
 #include <cmath>
+#include <iostream>
 #include <optional>
 #include "Scene.h"
 #include "Camera.h"
 #include "Raytracer.h"
 #include "Texture.h"
+#include "TextureCache.h"
 
 class MyGLApp : public GLApp {
 public:
@@ -12,12 +14,18 @@ public:
 	Image image{ 600,600 };
 
 	bool drawDebug = false;
+	Scene texturedScene;
 
 	MyGLApp() : GLApp{ 600,600,1,"Texturing" } {}
 
 	virtual void init() override {
 		GL(glDisable(GL_CULL_FACE));
-		Scene texturedScene = Scene::genTexturedScene();
+		texturedScene = Scene::genTexturedScene();
+
+		const TextureCacheStats cacheStats = TextureCache::instance().getStats();
+		std::cout << "texture cache: " << cacheStats.hits << " hits, " << cacheStats.misses << " misses, "
+		          << (cacheStats.bytes >> 10) << " KiB in " << cacheStats.entries << " entries" << std::endl;
+
 		render(texturedScene, 5, image);
 		render(texturedScene, 5, debugImage, true);
 	}
@@ -36,6 +44,15 @@ public:
 		renderer.setCamera(camera);
 		renderer.setScene(scene);
 		renderer.render(image);
+
+		if (!debug && scene.getRayTermination().enabled) {
+			const std::vector<BounceStats>& stats = renderer.getBounceStats();
+			for (size_t bounce = 0; bounce < stats.size(); ++bounce) {
+				std::cout << "bounce " << bounce << ": " << stats[bounce].spawned << " rays, "
+				          << stats[bounce].terminated << " terminated, "
+				          << stats[bounce].survived << " survived the roulette" << std::endl;
+			}
+		}
 	}
 
 	virtual void draw() override {
@@ -49,6 +66,13 @@ public:
 		if (key == GLENV_KEY_SPACE && action == GLENV_PRESS) {
 			drawDebug = !drawDebug;
 		}
+		// toggles the early termination of rays that hardly contribute to the image
+		if (key == GLENV_KEY_R && action == GLENV_PRESS) {
+			RayTermination termination = texturedScene.getRayTermination();
+			termination.enabled = !termination.enabled;
+			texturedScene.setRayTermination(termination);
+			render(texturedScene, 5, image);
+		}
 	}
 
 } myApp;
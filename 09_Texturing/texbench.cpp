@@ -0,0 +1,168 @@
+#include <Image.h>
+#include <Rand.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Texture.h"
+
+// Micro-benchmark of the texel layouts: samples one texture bilinearly with
+// a coherent access pattern (a rotated, slightly magnified quad rendered in
+// scanline order, as the camera rays of the raytracer would) and with
+// uniformly random texture coordinates, once per layout and format.
+
+struct BenchSettings
+{
+	std::string texture = "Earth.png";
+	uint32_t size = 0;	// 0 loads texture, otherwise a noise texture of size x size texels
+	uint32_t samples = 1 << 22;
+	uint32_t repeat = 3;
+};
+
+static void usage()
+{
+	std::cout << "Usage: texture-bench [options]\n"
+	          << "  --texture FILE   texture to sample (default Earth.png)\n"
+	          << "  --size N         sample a generated N x N noise texture instead\n"
+	          << "  --samples N      lookups per run (default 4194304)\n"
+	          << "  --repeat N       runs per configuration, the fastest counts (default 3)\n";
+}
+
+static bool parseArguments(int argc, char** argv, BenchSettings& settings)
+{
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--help" || arg == "-h") {
+			usage();
+			return false;
+		}
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << arg << std::endl;
+			return false;
+		}
+		const std::string value = argv[++i];
+		if (arg == "--texture") settings.texture = value;
+		else if (arg == "--size") settings.size = uint32_t(std::stoul(value));
+		else if (arg == "--samples") settings.samples = std::max(1u, uint32_t(std::stoul(value)));
+		else if (arg == "--repeat") settings.repeat = std::max(1u, uint32_t(std::stoul(value)));
+		else {
+			std::cerr << "Unknown option " << arg << std::endl;
+			usage();
+			return false;
+		}
+	}
+	return true;
+}
+
+static std::vector<TextureCoordinates> coherentPattern(uint32_t count)
+{
+	// a square of the screen covering about 3/4 of the texture, rotated by 30
+	// degrees so the scanlines cut through the texel rows
+	const uint32_t side = uint32_t(std::sqrt(float(count)));
+	const float c = std::cos(0.5236f) * 0.75f / side;
+	const float s = std::sin(0.5236f) * 0.75f / side;
+	std::vector<TextureCoordinates> texCoords;
+	texCoords.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		const float x = float(i % side);
+		const float y = float(i / side % side);
+		texCoords.push_back({ 0.1f + x * c - y * s, 0.2f + x * s + y * c });
+	}
+	return texCoords;
+}
+
+static std::vector<TextureCoordinates> randomPattern(uint32_t count, Random& random)
+{
+	std::vector<TextureCoordinates> texCoords;
+	texCoords.reserve(count);
+	for (uint32_t i = 0; i < count; ++i)
+		texCoords.push_back({ random.rand01(), random.rand01() });
+	return texCoords;
+}
+
+// returns the fastest time per lookup in nanoseconds and the sum of all colors
+static double run(const Texture& texture, const std::vector<TextureCoordinates>& texCoords,
+                  uint32_t repeat, Vec3& sum)
+{
+	double best = 0.0;
+	for (uint32_t r = 0; r < repeat; ++r) {
+		Vec3 total{ 0.0f, 0.0f, 0.0f };
+		const auto start = std::chrono::steady_clock::now();
+		for (const TextureCoordinates& tc : texCoords)
+			total = total + texture.sample(tc);
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (r == 0 || seconds < best)
+			best = seconds;
+		sum = total;
+	}
+	return best * 1e9 / double(texCoords.size());
+}
+
+int main(int argc, char** argv)
+{
+	BenchSettings settings;
+	if (!parseArguments(argc, argv, settings))
+		return EXIT_FAILURE;
+
+	Random random(1);
+
+	// TRILINEAR without differentials filters bilinearly in level 0
+	Texture texture = settings.size > 0 ? [&]() {
+		Image noise(settings.size, settings.size, 3);
+		for (uint8_t& value : noise.data)
+			value = uint8_t(random.rand<uint32_t>(0, 256));
+		return Texture(noise, FilterMode::TRILINEAR, BorderMode::REPEAT);
+	}() : Texture(settings.texture, FilterMode::TRILINEAR);
+
+	if (texture.getWidth() == 0 || texture.getHeight() == 0)
+		return EXIT_FAILURE;
+
+	std::cout << "Texture " << texture.getWidth() << " x " << texture.getHeight() << ", "
+	          << settings.samples << " bilinear lookups per run\n\n";
+
+	struct Configuration {
+		const char* name;
+		TexelLayout layout;
+		TexelFormat format;
+	};
+	const Configuration configurations[] = {
+		{ "row-major RGB8", TexelLayout::ROW_MAJOR, TexelFormat::RGBA8 },
+		{ "tiled RGBA8", TexelLayout::TILED, TexelFormat::RGBA8 },
+		{ "tiled RGBA32F", TexelLayout::TILED, TexelFormat::RGBA32F },
+	};
+	const std::pair<const char*, std::vector<TextureCoordinates>> patterns[] = {
+		{ "coherent", coherentPattern(settings.samples) },
+		{ "random", randomPattern(settings.samples, random) },
+	};
+
+	std::cout << std::left << std::setw(18) << "layout";
+	for (const auto& pattern : patterns)
+		std::cout << std::right << std::setw(16) << (std::string(pattern.first) + " ns");
+	std::cout << "\n" << std::fixed << std::setprecision(2);
+
+	Vec3 reference[2];
+	bool identical = true;
+	for (size_t c = 0; c < std::size(configurations); ++c) {
+		texture.setTexelLayout(configurations[c].layout, configurations[c].format);
+		std::cout << std::left << std::setw(18) << configurations[c].name;
+		for (size_t p = 0; p < std::size(patterns); ++p) {
+			Vec3 sum;
+			const double nanoseconds = run(texture, patterns[p].second, settings.repeat, sum);
+			if (c == 0)
+				reference[p] = sum;
+			else if (sum != reference[p])
+				identical = false;
+			std::cout << std::right << std::setw(16) << nanoseconds;
+		}
+		std::cout << "\n";
+	}
+
+	std::cout << "\nAll layouts return " << (identical ? "identical" : "DIFFERENT") << " colors\n";
+	return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}